@@ -0,0 +1,123 @@
+// Fleet-mode scaling benchmark: simulated ship/drone pairs feed FleetFollower the way the
+// MAVSDK callbacks do, and the run reports CPU per pair and update latency (ship sample
+// receipt -> home command) as the number of pairs grows.
+//
+//   fleet_benchmark [rate_hz] [seconds] [workers] [pair counts...]
+
+#include "fleet.h"
+#include <sys/resource.h>
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+#include <vector>
+
+using namespace std::chrono;
+
+namespace {
+
+double cpu_seconds(int who) {
+    rusage usage{};
+    getrusage(who, &usage);
+    return usage.ru_utime.tv_sec + usage.ru_utime.tv_usec / 1e6 + usage.ru_stime.tv_sec +
+           usage.ru_stime.tv_usec / 1e6;
+}
+
+struct RunResult {
+    double cpu_us_per_pair_per_s;
+    double p50_us;
+    double p99_us;
+    double max_us;
+    uint64_t updates;
+};
+
+RunResult run(std::size_t pair_count, double rate_hz, double seconds, std::size_t workers) {
+    std::vector<PairConfig> pairs(pair_count);
+    for (std::size_t i = 0; i < pair_count; ++i) {
+        // 1 cm threshold: every ship sample produces a home command, so every update is timed.
+        pairs[i] = {"pair" + std::to_string(i), static_cast<uint8_t>(1 + i % 255), 1, 0.01f};
+    }
+
+    std::vector<std::vector<int64_t>> latencies(pair_count);
+    for (auto& pair_latencies : latencies) {
+        pair_latencies.reserve(static_cast<std::size_t>(rate_hz * seconds) + 16);
+    }
+
+    WorkerPool pool(workers);
+    FleetFollower* follower_ptr = nullptr;
+    FleetFollower follower(pairs, milliseconds(0), pool, [&](std::size_t pair, const HomeCommand& command) {
+        latencies[pair].push_back(monotonic_ns() - command.sample_time_ns);
+        // The simulated drone accepts the new home immediately.
+        follower_ptr->on_drone_home(pair, {command.latitude_deg, command.longitude_deg, 0, monotonic_ns()});
+    });
+    follower_ptr = &follower;
+
+    for (std::size_t i = 0; i < pair_count; ++i) {
+        follower.on_drone_home(i, {47.3977419 + i * 1e-3, 8.5455938, 0, monotonic_ns()});
+    }
+
+    // Ships circle their start point at ~10 m/s.
+    const double process_cpu_before = cpu_seconds(RUSAGE_SELF);
+    const double feeder_cpu_before = cpu_seconds(RUSAGE_THREAD);
+    const auto period = duration_cast<steady_clock::duration>(duration<double>(1.0 / rate_hz));
+    const auto start = steady_clock::now();
+    const auto ticks = static_cast<long>(rate_hz * seconds);
+    for (long tick = 0; tick < ticks; ++tick) {
+        const double t = tick / rate_hz;
+        for (std::size_t i = 0; i < pair_count; ++i) {
+            const double angle = 0.09 * t + i;
+            follower.on_ship_position(i, {{47.3977419 + i * 1e-3 + 1e-3 * std::sin(angle),
+                                           8.5455938 + 1e-3 * std::cos(angle), 0, monotonic_ns()},
+                                          static_cast<uint32_t>(t * 1000)});
+        }
+        std::this_thread::sleep_until(start + period * (tick + 1));
+    }
+    std::this_thread::sleep_for(milliseconds(50));
+    const double feeder_cpu = cpu_seconds(RUSAGE_THREAD) - feeder_cpu_before;
+    const double process_cpu = cpu_seconds(RUSAGE_SELF) - process_cpu_before;
+    pool.stop();
+
+    std::vector<int64_t> all;
+    for (const auto& pair_latencies : latencies) {
+        all.insert(all.end(), pair_latencies.begin(), pair_latencies.end());
+    }
+    std::sort(all.begin(), all.end());
+    auto percentile = [&all](double p) {
+        return all.empty() ? 0.0 : all[static_cast<std::size_t>(p * (all.size() - 1))] / 1e3;
+    };
+
+    RunResult result;
+    // The feeder stands in for MAVSDK's receive threads and is not counted.
+    result.cpu_us_per_pair_per_s = (process_cpu - feeder_cpu) * 1e6 / seconds / pair_count;
+    result.p50_us = percentile(0.50);
+    result.p99_us = percentile(0.99);
+    result.max_us = all.empty() ? 0.0 : all.back() / 1e3;
+    result.updates = all.size();
+    return result;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    const double rate_hz = argc > 1 ? std::atof(argv[1]) : 10.0;
+    const double seconds = argc > 2 ? std::atof(argv[2]) : 3.0;
+    const std::size_t workers = argc > 3 ? std::strtoul(argv[3], nullptr, 10) : 0;
+    std::vector<std::size_t> counts;
+    for (int i = 4; i < argc; ++i) {
+        counts.push_back(std::strtoul(argv[i], nullptr, 10));
+    }
+    if (counts.empty()) {
+        counts = {1, 10, 50, 100, 250, 500};
+    }
+
+    const std::size_t threads = workers ? workers : std::max(1u, std::thread::hardware_concurrency());
+    std::printf("rate %.1f Hz, %.1f s per run, %zu workers\n", rate_hz, seconds, threads);
+    std::printf("%8s %14s %10s %10s %10s %10s\n", "pairs", "cpu_us/pair/s", "p50_us", "p99_us", "max_us", "updates");
+    for (std::size_t count : counts) {
+        const RunResult r = run(count, rate_hz, seconds, workers);
+        std::printf("%8zu %14.1f %10.1f %10.1f %10.1f %10llu\n", count, r.cpu_us_per_pair_per_s, r.p50_us, r.p99_us,
+                    r.max_us, static_cast<unsigned long long>(r.updates));
+    }
+    return 0;
+}
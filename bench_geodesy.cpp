@@ -0,0 +1,251 @@
+// Microbenchmarks for coordinates.cpp and the waypoint-update pipeline. Prints one JSON
+// object per line so runs can be diffed or loaded by a regression checker:
+//
+//   geodesy_benchmark [min_time_ms] > results.jsonl
+
+#include "coordinates.h"
+#include "follow_logic.h"
+#include "geodesy.h"
+#include "mission_sync.h"
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <random>
+#include <string>
+#include <vector>
+
+using mavsdk::MissionRaw;
+
+namespace {
+
+std::atomic<uint64_t> allocation_count{0};
+
+} // namespace
+
+void* operator new(std::size_t size) {
+    allocation_count.fetch_add(1, std::memory_order_relaxed);
+    if (void* p = std::malloc(size ? size : 1)) {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept {
+    std::free(p);
+}
+
+void operator delete(void* p, std::size_t) noexcept {
+    std::free(p);
+}
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+double min_time_s = 0.2;
+volatile double sink;
+
+// Calls `fn` until min_time_s has passed and prints ns per item and allocations per call.
+template <typename Fn>
+void run(const char* name, std::size_t items, Fn fn) {
+    fn();  // warm-up, also lets scratch buffers reach their steady-state size
+
+    uint64_t iterations = 0;
+    const uint64_t allocations_before = allocation_count.load();
+    const auto start = Clock::now();
+    auto elapsed = Clock::duration::zero();
+    while (elapsed < std::chrono::duration<double>(min_time_s)) {
+        fn();
+        ++iterations;
+        elapsed = Clock::now() - start;
+    }
+    const uint64_t allocations = allocation_count.load() - allocations_before;
+
+    const double ns = std::chrono::duration<double, std::nano>(elapsed).count();
+    const double ns_per_call = ns / iterations;
+    std::printf("{\"benchmark\":\"%s\",\"items\":%zu,\"simd\":%s,\"iterations\":%llu,"
+                "\"ns_per_call\":%.1f,\"ns_per_item\":%.3f,\"items_per_s\":%.0f,\"allocs_per_call\":%.2f}\n",
+                name, items, geodesy_simd_enabled() ? "true" : "false",
+                static_cast<unsigned long long>(iterations), ns_per_call, ns_per_call / items,
+                items * 1e9 / ns_per_call, static_cast<double>(allocations) / iterations);
+    std::fflush(stdout);
+}
+
+struct Points {
+    std::vector<double> lat1, lon1, lat2, lon2, out_lat, out_lon;
+
+    explicit Points(std::size_t n) :
+        lat1(n), lon1(n), lat2(n), lon2(n), out_lat(n), out_lon(n)
+    {
+        // ship/drone pairs a few km apart around Zurich
+        std::mt19937_64 rng(42);
+        std::uniform_real_distribution<double> offset(-0.05, 0.05);
+        for (std::size_t i = 0; i < n; ++i) {
+            lat1[i] = 47.3977419 + offset(rng);
+            lon1[i] = 8.5455938 + offset(rng);
+            lat2[i] = lat1[i] + offset(rng);
+            lon2[i] = lon1[i] + offset(rng);
+        }
+    }
+
+    LatLonSpan from() const { return {lat1.data(), lon1.data(), lat1.size()}; }
+    LatLonSpan to() const { return {lat2.data(), lon2.data(), lat2.size()}; }
+    MutableLatLonSpan out() { return {out_lat.data(), out_lon.data(), out_lat.size()}; }
+};
+
+// Vehicle stand-in that accepts every transfer instantly.
+class MockMissionLink : public MissionLink {
+public:
+    explicit MockMissionLink(MissionItems items) : _items(std::move(items)) {}
+
+    bool download(MissionItems& items) override {
+        items = _items;
+        return true;
+    }
+    bool upload(const MissionItems& items) override {
+        _items = items;
+        return true;
+    }
+    bool write_partial(const MissionItems& items, uint16_t start, uint16_t end) override {
+        std::copy(items.begin() + start, items.begin() + end + 1, _items.begin() + start);
+        return true;
+    }
+
+private:
+    MissionItems _items;
+};
+
+MissionItems make_mission(std::size_t n) {
+    MissionItems items(n);
+    for (std::size_t i = 0; i < n; ++i) {
+        items[i].seq = static_cast<uint32_t>(i);
+        items[i].frame = MAV_FRAME_GLOBAL_RELATIVE_ALT_INT;
+        items[i].command = MAV_CMD_NAV_WAYPOINT;
+        items[i].autocontinue = 1;
+        items[i].x = 473977419 + static_cast<int32_t>(i % 1000) * 100;
+        items[i].y = 85455938 + static_cast<int32_t>(i / 1000) * 100;
+        items[i].z = 20;
+    }
+    return items;
+}
+
+void bench_scalar() {
+    const std::vector<double> a = {47.3977419, 8.5455938};
+    const std::vector<double> b = {47.3980000, 8.5460000};
+    run("calculate_bearing", 1, [&]() { sink = calculate_bearing(a, b); });
+    run("haversine_distance", 1, [&]() { sink = haversine_distance(a, b); });
+    run("translate_coordinates", 1, [&]() { sink = translate_coordinates(a, 45.0, 0.1)[0]; });
+
+    const PositionSample ship{47.3980000, 8.5460000, 0, 0};
+    const PositionSample home{47.3977419, 8.5455938, 0, 0};
+    run("evaluate_follow", 1, [&]() { sink = evaluate_follow(ship, home, 10).distance_m; });
+}
+
+void bench_batch() {
+    for (std::size_t n = 1; n <= (1u << 20); n *= 4) {
+        Points points(n);
+        double* out = points.out_lat.data();
+        run("calculate_bearing_batch", n, [&]() {
+            calculate_bearing_batch(points.from(), points.to(), out);
+            sink = out[0];
+        });
+        run("haversine_distance_batch", n, [&]() {
+            haversine_distance_batch(points.from(), points.to(), out);
+            sink = out[0];
+        });
+        run("translate_coordinates_batch", n, [&]() {
+            translate_coordinates_batch(points.from(), 45.0, 0.1, points.out());
+            sink = out[0];
+        });
+    }
+}
+
+// One origin against many points, as when a frame is built once per home or ship fix.
+template <GeodesyTier Tier, typename T>
+void bench_tier(const char* name, const Points& points) {
+    const Geodesy<Tier, T> frame(points.lat1[0], points.lon1[0]);
+    const std::size_t n = points.lat2.size();
+    run(name, n, [&]() {
+        T total = 0;
+        for (std::size_t i = 0; i < n; ++i) {
+            total += frame.distance_m(points.lat2[i], points.lon2[i]);
+        }
+        sink = total;
+    });
+}
+
+void bench_tiers() {
+    const Points points(1024);
+    bench_tier<GeodesyTier::LocalTangentPlane, double>("geodesy_ltp_double", points);
+    bench_tier<GeodesyTier::LocalTangentPlane, float>("geodesy_ltp_float", points);
+    bench_tier<GeodesyTier::Spherical, double>("geodesy_spherical_double", points);
+    bench_tier<GeodesyTier::Spherical, float>("geodesy_spherical_float", points);
+    bench_tier<GeodesyTier::Wgs84, double>("geodesy_wgs84_double", points);
+}
+
+// The update_waypoints path: translate the cached mission and push the delta.
+void bench_mission() {
+    for (std::size_t n : {10u, 100u, 1000u, 10000u}) {
+        const MissionItems base = make_mission(n);
+        MissionItems out;
+        run("translate_mission", n, [&]() {
+            translate_mission(base, 45.0, 0.1, out);
+            sink = out[0].x;
+        });
+
+        MockMissionLink link(base);
+        MissionSync mission_sync(link);
+        mission_sync.load();
+        double bearing = 0;
+        run("mission_sync_update", n, [&]() {
+            // a new ship offset every call, so every positional item is re-sent
+            bearing = bearing >= 359 ? 0 : bearing + 1;
+            mission_sync.update(bearing, 0.1);
+            sink = static_cast<double>(mission_sync.stats().items_sent);
+        });
+        run("mission_sync_update_unchanged", n, [&]() {
+            mission_sync.update(bearing, 0.1);
+            sink = static_cast<double>(mission_sync.stats().items_sent);
+        });
+    }
+}
+
+// Ship-relative missions: rotate and place the cached body-frame offsets.
+void bench_mission_frame() {
+    WorkerPool pool;
+    for (std::size_t n : {10u, 100u, 1000u, 10000u, 100000u, 1000000u}) {
+        MissionFrame frame;
+        frame.capture(make_mission(n), {47.3977419, 8.5455938, 30});
+        std::vector<int32_t> x(n);
+        std::vector<int32_t> y(n);
+        double heading = 0;
+        run("mission_frame_transform", n, [&]() {
+            heading = heading >= 359 ? 0 : heading + 1;
+            frame.transform({47.3980000, 8.5460000, heading}, x.data(), y.data());
+            sink = x[0];
+        });
+        if (n >= MissionFrame::PARALLEL_MIN_ITEMS) {
+            run("mission_frame_transform_parallel", n, [&]() {
+                heading = heading >= 359 ? 0 : heading + 1;
+                frame.transform({47.3980000, 8.5460000, heading}, x.data(), y.data(), &pool);
+                sink = x[0];
+            });
+        }
+    }
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    if (argc > 1) {
+        min_time_s = std::atof(argv[1]) / 1000.0;
+    }
+    bench_scalar();
+    bench_batch();
+    bench_tiers();
+    bench_mission();
+    bench_mission_frame();
+    return 0;
+}
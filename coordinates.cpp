@@ -1,13 +1,26 @@
 #include "coordinates.h"
 #include <cmath>
 
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define COORDINATES_HAVE_AVX2 1
+#include <immintrin.h>
+#define AVX2_TARGET __attribute__((target("avx2,fma")))
+#endif
+
 const double EARTH_RADIUS = 6371.0;
 
-double calculate_bearing(std::vector<double> coord1, std::vector<double> coord2) {
-    double lat1 = coord1[0] * M_PI / 180.0;
-    double lon1 = coord1[1] * M_PI / 180.0;
-    double lat2 = coord2[0] * M_PI / 180.0;
-    double lon2 = coord2[1] * M_PI / 180.0;
+namespace {
+
+const double DEG_TO_RAD = M_PI / 180.0;
+const double RAD_TO_DEG = 180.0 / M_PI;
+
+// Scalar kernels shared by the vector API and the batch fallback / tail loops.
+
+double bearing_deg(double lat1_deg, double lon1_deg, double lat2_deg, double lon2_deg) {
+    double lat1 = lat1_deg * DEG_TO_RAD;
+    double lon1 = lon1_deg * DEG_TO_RAD;
+    double lat2 = lat2_deg * DEG_TO_RAD;
+    double lon2 = lon2_deg * DEG_TO_RAD;
 
     double delta_lon = lon2 - lon1;
 
@@ -15,18 +28,18 @@ double calculate_bearing(std::vector<double> coord1, std::vector<double> coord2)
     double y = std::cos(lat1) * std::sin(lat2) - std::sin(lat1) * std::cos(lat2) * std::cos(delta_lon);
 
     double bearing = std::atan2(x, y);
-    bearing = bearing * 180.0 / M_PI;
+    bearing = bearing * RAD_TO_DEG;
     bearing = std::fmod((bearing + 360.0), 360.0);
     bearing = std::fmod((bearing + 180.0), 360.0);
 
     return bearing;
 }
 
-double haversine_distance(std::vector<double> coord1, std::vector<double> coord2) {
-    double lat1 = coord1[0] * M_PI / 180.0;
-    double lon1 = coord1[1] * M_PI / 180.0;
-    double lat2 = coord2[0] * M_PI / 180.0;
-    double lon2 = coord2[1] * M_PI / 180.0;
+double distance_km(double lat1_deg, double lon1_deg, double lat2_deg, double lon2_deg) {
+    double lat1 = lat1_deg * DEG_TO_RAD;
+    double lon1 = lon1_deg * DEG_TO_RAD;
+    double lat2 = lat2_deg * DEG_TO_RAD;
+    double lon2 = lon2_deg * DEG_TO_RAD;
 
     double dlat = lat2 - lat1;
     double dlon = lon2 - lon1;
@@ -35,24 +48,286 @@ double haversine_distance(std::vector<double> coord1, std::vector<double> coord2
                std::cos(lat1) * std::cos(lat2) * std::sin(dlon / 2) * std::sin(dlon / 2);
     double c = 2 * std::atan2(std::sqrt(a), std::sqrt(1 - a));
 
-    double distance = EARTH_RADIUS * c;
-    return distance;
+    return EARTH_RADIUS * c;
+}
+
+// sin/cos of the translation bearing and angular distance, computed once per batch.
+struct TranslateParams {
+    double sin_bearing;
+    double cos_bearing;
+    double sin_dist;
+    double cos_dist;
+};
+
+TranslateParams make_translate_params(double bearing, double distance) {
+    double bearing_rad = bearing * DEG_TO_RAD;
+    double angular = distance / EARTH_RADIUS;
+    return {std::sin(bearing_rad), std::cos(bearing_rad), std::sin(angular), std::cos(angular)};
+}
+
+void translate_point(const TranslateParams& p, double lat_deg, double lon_deg, double& out_lat, double& out_lon) {
+    double lat = lat_deg * DEG_TO_RAD;
+    double lon = lon_deg * DEG_TO_RAD;
+
+    double sin_new_lat = std::sin(lat) * p.cos_dist + std::cos(lat) * p.sin_dist * p.cos_bearing;
+    double new_lat = std::asin(sin_new_lat);
+    double new_lon = lon + std::atan2(p.sin_bearing * p.sin_dist * std::cos(lat),
+                                      p.cos_dist - std::sin(lat) * sin_new_lat);
+
+    out_lat = new_lat * RAD_TO_DEG;
+    out_lon = new_lon * RAD_TO_DEG;
+}
+
+#ifdef COORDINATES_HAVE_AVX2
+
+// 4-wide double kernels. Polynomials are the Cephes sin/cos/atan approximations,
+// accurate to a few ulp over the ranges used here (|x| < 8 rad).
+
+AVX2_TARGET inline __m256d set1(double v) {
+    return _mm256_set1_pd(v);
+}
+
+AVX2_TARGET inline __m256d negate_where(__m256d v, __m256d mask) {
+    return _mm256_xor_pd(v, _mm256_and_pd(mask, set1(-0.0)));
+}
+
+AVX2_TARGET inline void sincos_pd(__m256d x, __m256d& s, __m256d& c) {
+    // x = n * pi/2 + r with |r| <= pi/4, using a three-part pi/2 for the reduction.
+    const __m256d n = _mm256_round_pd(_mm256_mul_pd(x, set1(M_2_PI)), _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+    __m256d r = _mm256_fnmadd_pd(n, set1(1.57079632673412561417e+00), x);
+    r = _mm256_fnmadd_pd(n, set1(6.07710050630396597660e-11), r);
+    r = _mm256_fnmadd_pd(n, set1(2.02226624879595063154e-21), r);
+    const __m256d z = _mm256_mul_pd(r, r);
+
+    __m256d ps = set1(1.58962301576546568060e-10);
+    ps = _mm256_fmadd_pd(ps, z, set1(-2.50507477628578072866e-8));
+    ps = _mm256_fmadd_pd(ps, z, set1(2.75573136213857245213e-6));
+    ps = _mm256_fmadd_pd(ps, z, set1(-1.98412698295895385996e-4));
+    ps = _mm256_fmadd_pd(ps, z, set1(8.33333333332211858878e-3));
+    ps = _mm256_fmadd_pd(ps, z, set1(-1.66666666666666307295e-1));
+    const __m256d sin_r = _mm256_fmadd_pd(_mm256_mul_pd(r, z), ps, r);
+
+    __m256d pc = set1(-1.13585365213876817300e-11);
+    pc = _mm256_fmadd_pd(pc, z, set1(2.08757008419747316778e-9));
+    pc = _mm256_fmadd_pd(pc, z, set1(-2.75573141792967388112e-7));
+    pc = _mm256_fmadd_pd(pc, z, set1(2.48015872888517045348e-5));
+    pc = _mm256_fmadd_pd(pc, z, set1(-1.38888888888730564116e-3));
+    pc = _mm256_fmadd_pd(pc, z, set1(4.16666666666665929218e-2));
+    const __m256d cos_r = _mm256_fmadd_pd(_mm256_mul_pd(z, z), pc, _mm256_fnmadd_pd(set1(0.5), z, set1(1.0)));
+
+    // Quadrant q = n mod 4 selects and signs the two polynomials.
+    const __m256d q = _mm256_fnmadd_pd(set1(4.0), _mm256_floor_pd(_mm256_mul_pd(n, set1(0.25))), n);
+    const __m256d odd = _mm256_or_pd(_mm256_cmp_pd(q, set1(1.0), _CMP_EQ_OQ), _mm256_cmp_pd(q, set1(3.0), _CMP_EQ_OQ));
+    const __m256d sin_neg = _mm256_cmp_pd(q, set1(2.0), _CMP_GE_OQ);
+    const __m256d cos_neg = _mm256_or_pd(_mm256_cmp_pd(q, set1(1.0), _CMP_EQ_OQ), _mm256_cmp_pd(q, set1(2.0), _CMP_EQ_OQ));
+
+    s = negate_where(_mm256_blendv_pd(sin_r, cos_r, odd), sin_neg);
+    c = negate_where(_mm256_blendv_pd(cos_r, sin_r, odd), cos_neg);
+}
+
+AVX2_TARGET inline __m256d atan_pd(__m256d x) {
+    const __m256d sign = _mm256_and_pd(x, set1(-0.0));
+    const __m256d ax = _mm256_andnot_pd(set1(-0.0), x);
+
+    // Reduce to |t| <= 0.66 via atan(x) = pi/2 - atan(1/x) and pi/4 + atan((x-1)/(x+1)).
+    const __m256d big = _mm256_cmp_pd(ax, set1(2.41421356237309504880), _CMP_GT_OQ);
+    const __m256d mid = _mm256_andnot_pd(big, _mm256_cmp_pd(ax, set1(0.66), _CMP_GT_OQ));
+
+    __m256d t = ax;
+    t = _mm256_blendv_pd(t, _mm256_div_pd(_mm256_sub_pd(ax, set1(1.0)), _mm256_add_pd(ax, set1(1.0))), mid);
+    t = _mm256_blendv_pd(t, _mm256_div_pd(set1(-1.0), ax), big);
+    __m256d base = _mm256_and_pd(mid, set1(M_PI_4));
+    base = _mm256_blendv_pd(base, set1(M_PI_2), big);
+    __m256d extra = _mm256_and_pd(mid, set1(0.5 * 6.123233995736765886130e-17));
+    extra = _mm256_blendv_pd(extra, set1(6.123233995736765886130e-17), big);
+
+    const __m256d z = _mm256_mul_pd(t, t);
+    __m256d p = set1(-8.750608600031904122785e-1);
+    p = _mm256_fmadd_pd(p, z, set1(-1.615753718733365076637e1));
+    p = _mm256_fmadd_pd(p, z, set1(-7.500855792314704667340e1));
+    p = _mm256_fmadd_pd(p, z, set1(-1.228866684490136173410e2));
+    p = _mm256_fmadd_pd(p, z, set1(-6.485021904942025371773e1));
+    __m256d q = _mm256_add_pd(z, set1(2.485846490142306297962e1));
+    q = _mm256_fmadd_pd(q, z, set1(1.650270098316988542046e2));
+    q = _mm256_fmadd_pd(q, z, set1(4.328810604912902668951e2));
+    q = _mm256_fmadd_pd(q, z, set1(4.853903996359136964868e2));
+    q = _mm256_fmadd_pd(q, z, set1(1.945506571482613964425e2));
+
+    __m256d r = _mm256_fmadd_pd(t, _mm256_div_pd(_mm256_mul_pd(z, p), q), t);
+    r = _mm256_add_pd(base, _mm256_add_pd(r, extra));
+    return _mm256_or_pd(r, sign);
+}
+
+AVX2_TARGET inline __m256d atan2_pd(__m256d y, __m256d x) {
+    const __m256d zero = _mm256_setzero_pd();
+    const __m256d both_zero = _mm256_and_pd(_mm256_cmp_pd(x, zero, _CMP_EQ_OQ), _mm256_cmp_pd(y, zero, _CMP_EQ_OQ));
+
+    __m256d r = atan_pd(_mm256_div_pd(y, x));
+    // Left half-plane: shift by +/-pi following the sign of y, like std::atan2.
+    const __m256d x_neg = _mm256_cmp_pd(x, zero, _CMP_LT_OQ);
+    const __m256d pi_signed = _mm256_or_pd(set1(M_PI), _mm256_and_pd(y, set1(-0.0)));
+    r = _mm256_add_pd(r, _mm256_and_pd(x_neg, pi_signed));
+    return _mm256_andnot_pd(both_zero, r);
 }
 
-double translate_coordinates(std::vector<double> coord, double bearing, double distance) {
-    double lat = coord[0] * M_PI / 180.0;
-    double lon = coord[1] * M_PI / 180.0;
-    double bearing_rad = bearing * M_PI / 180.0;
+// positive fmod(v, 360) for the small, non-negative values produced by the bearing formula
+AVX2_TARGET inline __m256d wrap360_pd(__m256d v) {
+    return _mm256_fnmadd_pd(set1(360.0), _mm256_floor_pd(_mm256_mul_pd(v, set1(1.0 / 360.0))), v);
+}
+
+AVX2_TARGET void bearing_avx2(LatLonSpan from, LatLonSpan to, double* bearings, std::size_t n) {
+    const __m256d d2r = set1(DEG_TO_RAD);
+    for (std::size_t i = 0; i < n; i += 4) {
+        const __m256d lat1_deg = _mm256_loadu_pd(from.lat + i);
+        const __m256d lat2_deg = _mm256_loadu_pd(to.lat + i);
+        const __m256d lat1 = _mm256_mul_pd(lat1_deg, d2r);
+        const __m256d lat2 = _mm256_mul_pd(lat2_deg, d2r);
+        // Differences are taken in degrees: with FMA contraction, lat2 * k - lat1 * k is not 0 for equal inputs.
+        const __m256d dlat = _mm256_mul_pd(_mm256_sub_pd(lat2_deg, lat1_deg), d2r);
+        const __m256d dlon = _mm256_mul_pd(_mm256_sub_pd(_mm256_loadu_pd(to.lon + i), _mm256_loadu_pd(from.lon + i)), d2r);
+
+        __m256d sin_lat1, cos_lat1, sin_lat2, cos_lat2, sin_dlat, cos_dlat, sin_hdlon, cos_hdlon;
+        sincos_pd(lat1, sin_lat1, cos_lat1);
+        sincos_pd(lat2, sin_lat2, cos_lat2);
+        sincos_pd(dlat, sin_dlat, cos_dlat);
+        sincos_pd(_mm256_mul_pd(dlon, set1(0.5)), sin_hdlon, cos_hdlon);
+
+        // Same x/y as the scalar formula, rewritten as
+        // y = sin(lat2 - lat1) + 2 sin(lat1) cos(lat2) sin^2(dlon / 2) so it does not cancel
+        // (and is exactly 0 for coincident points, where the scalar path also yields 180).
+        const __m256d sin_dlon = _mm256_mul_pd(set1(2.0), _mm256_mul_pd(sin_hdlon, cos_hdlon));
+        const __m256d x = _mm256_mul_pd(cos_lat2, sin_dlon);
+        const __m256d y = _mm256_fmadd_pd(_mm256_mul_pd(set1(2.0), _mm256_mul_pd(sin_lat1, cos_lat2)),
+                                          _mm256_mul_pd(sin_hdlon, sin_hdlon), sin_dlat);
+
+        __m256d bearing = _mm256_mul_pd(atan2_pd(x, y), set1(RAD_TO_DEG));
+        bearing = wrap360_pd(_mm256_add_pd(bearing, set1(360.0)));
+        bearing = wrap360_pd(_mm256_add_pd(bearing, set1(180.0)));
+        _mm256_storeu_pd(bearings + i, bearing);
+    }
+}
+
+AVX2_TARGET void distance_avx2(LatLonSpan from, LatLonSpan to, double* distances, std::size_t n) {
+    const __m256d d2r = set1(DEG_TO_RAD);
+    for (std::size_t i = 0; i < n; i += 4) {
+        const __m256d lat1_deg = _mm256_loadu_pd(from.lat + i);
+        const __m256d lat2_deg = _mm256_loadu_pd(to.lat + i);
+        const __m256d lat1 = _mm256_mul_pd(lat1_deg, d2r);
+        const __m256d lat2 = _mm256_mul_pd(lat2_deg, d2r);
+        // Differences are taken in degrees: with FMA contraction, lat2 * k - lat1 * k is not 0 for equal inputs.
+        const __m256d dlat = _mm256_mul_pd(_mm256_sub_pd(lat2_deg, lat1_deg), d2r);
+        const __m256d dlon = _mm256_mul_pd(_mm256_sub_pd(_mm256_loadu_pd(to.lon + i), _mm256_loadu_pd(from.lon + i)), d2r);
+
+        __m256d sin_lat1, cos_lat1, sin_lat2, cos_lat2, sin_hdlat, cos_hdlat, sin_hdlon, cos_hdlon;
+        sincos_pd(lat1, sin_lat1, cos_lat1);
+        sincos_pd(lat2, sin_lat2, cos_lat2);
+        sincos_pd(_mm256_mul_pd(dlat, set1(0.5)), sin_hdlat, cos_hdlat);
+        sincos_pd(_mm256_mul_pd(dlon, set1(0.5)), sin_hdlon, cos_hdlon);
+
+        const __m256d a = _mm256_fmadd_pd(_mm256_mul_pd(cos_lat1, cos_lat2), _mm256_mul_pd(sin_hdlon, sin_hdlon),
+                                          _mm256_mul_pd(sin_hdlat, sin_hdlat));
+        const __m256d c = _mm256_mul_pd(set1(2.0), atan2_pd(_mm256_sqrt_pd(a), _mm256_sqrt_pd(_mm256_sub_pd(set1(1.0), a))));
+        _mm256_storeu_pd(distances + i, _mm256_mul_pd(c, set1(EARTH_RADIUS)));
+    }
+}
+
+AVX2_TARGET void translate_avx2(LatLonSpan coords, const TranslateParams& p, MutableLatLonSpan out, std::size_t n) {
+    const __m256d d2r = set1(DEG_TO_RAD);
+    const __m256d r2d = set1(RAD_TO_DEG);
+    for (std::size_t i = 0; i < n; i += 4) {
+        const __m256d lat = _mm256_mul_pd(_mm256_loadu_pd(coords.lat + i), d2r);
+        const __m256d lon = _mm256_mul_pd(_mm256_loadu_pd(coords.lon + i), d2r);
+
+        __m256d sin_lat, cos_lat;
+        sincos_pd(lat, sin_lat, cos_lat);
+
+        const __m256d sin_new_lat = _mm256_fmadd_pd(sin_lat, set1(p.cos_dist),
+                                                    _mm256_mul_pd(cos_lat, set1(p.sin_dist * p.cos_bearing)));
+        // asin(v) = atan2(v, sqrt(1 - v^2))
+        const __m256d cos_new_lat = _mm256_sqrt_pd(_mm256_mul_pd(_mm256_sub_pd(set1(1.0), sin_new_lat),
+                                                                 _mm256_add_pd(set1(1.0), sin_new_lat)));
+        const __m256d new_lat = atan2_pd(sin_new_lat, cos_new_lat);
+        const __m256d dlon = atan2_pd(_mm256_mul_pd(set1(p.sin_bearing * p.sin_dist), cos_lat),
+                                      _mm256_fnmadd_pd(sin_lat, sin_new_lat, set1(p.cos_dist)));
+
+        _mm256_storeu_pd(out.lat + i, _mm256_mul_pd(new_lat, r2d));
+        _mm256_storeu_pd(out.lon + i, _mm256_mul_pd(_mm256_add_pd(lon, dlon), r2d));
+    }
+}
+
+bool detect_avx2() {
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+}
+
+#endif // COORDINATES_HAVE_AVX2
+
+// Number of leading elements handled by the vector kernels; the rest go through the scalar path.
+std::size_t simd_prefix(std::size_t n) {
+    return geodesy_simd_enabled() ? n - n % 4 : 0;
+}
+
+} // namespace
+
+double calculate_bearing(const std::vector<double>& coord1, const std::vector<double>& coord2) {
+    return bearing_deg(coord1[0], coord1[1], coord2[0], coord2[1]);
+}
+
+double haversine_distance(const std::vector<double>& coord1, const std::vector<double>& coord2) {
+    return distance_km(coord1[0], coord1[1], coord2[0], coord2[1]);
+}
+
+std::vector<double> translate_coordinates(const std::vector<double>& coord, double bearing, double distance) {
+    std::vector<double> results(2);
+    translate_point(make_translate_params(bearing, distance), coord[0], coord[1], results[0], results[1]);
+    return results;
+}
+
+bool geodesy_simd_enabled() {
+#ifdef COORDINATES_HAVE_AVX2
+    static const bool enabled = detect_avx2();
+    return enabled;
+#else
+    return false;
+#endif
+}
 
-    double new_lat = std::asin(std::sin(lat) * std::cos(distance / EARTH_RADIUS) +
-                               std::cos(lat) * std::sin(distance / EARTH_RADIUS) * std::cos(bearing_rad));
-    double new_lon = lon + std::atan2(std::sin(bearing_rad) * std::sin(distance / EARTH_RADIUS) * std::cos(lat),
-                                      std::cos(distance / EARTH_RADIUS) - std::sin(lat) * std::sin(new_lat));
-    double results[2];
-    
-    results[0] = new_lat * 180.0 / M_PI;
-    results[1] = new_lon * 180.0 / M_PI;
+void calculate_bearing_batch(LatLonSpan from, LatLonSpan to, double* bearings) {
+    const std::size_t n = from.size;
+    std::size_t i = simd_prefix(n);
+#ifdef COORDINATES_HAVE_AVX2
+    if (i > 0) {
+        bearing_avx2(from, to, bearings, i);
+    }
+#endif
+    for (; i < n; ++i) {
+        bearings[i] = bearing_deg(from.lat[i], from.lon[i], to.lat[i], to.lon[i]);
+    }
+}
 
+void haversine_distance_batch(LatLonSpan from, LatLonSpan to, double* distances) {
+    const std::size_t n = from.size;
+    std::size_t i = simd_prefix(n);
+#ifdef COORDINATES_HAVE_AVX2
+    if (i > 0) {
+        distance_avx2(from, to, distances, i);
+    }
+#endif
+    for (; i < n; ++i) {
+        distances[i] = distance_km(from.lat[i], from.lon[i], to.lat[i], to.lon[i]);
+    }
+}
 
-    return results[2];
-}
\ No newline at end of file
+void translate_coordinates_batch(LatLonSpan coords, double bearing, double distance, MutableLatLonSpan out) {
+    const TranslateParams params = make_translate_params(bearing, distance);
+    const std::size_t n = coords.size;
+    std::size_t i = simd_prefix(n);
+#ifdef COORDINATES_HAVE_AVX2
+    if (i > 0) {
+        translate_avx2(coords, params, out, i);
+    }
+#endif
+    for (; i < n; ++i) {
+        translate_point(params, coords.lat[i], coords.lon[i], out.lat[i], out.lon[i]);
+    }
+}
@@ -1,10 +1,42 @@
 #ifndef COORDINATES_H
 #define COORDINATES_H
 
+#include <cstddef>
 #include <vector>
 
-double calculate_bearing(std::vector<double> coord1, std::vector<double> coord2);
-double haversine_distance(std::vector<double> coord1, std::vector<double> coord2);
-double translate_coordinates(std::vector<double> coord, double bearing, double distance);
+double calculate_bearing(const std::vector<double>& coord1, const std::vector<double>& coord2);
+double haversine_distance(const std::vector<double>& coord1, const std::vector<double>& coord2);
+std::vector<double> translate_coordinates(const std::vector<double>& coord, double bearing, double distance);
+
+// Structure-of-arrays view over latitude/longitude buffers in degrees.
+// The batch functions below never allocate; the caller owns every buffer.
+struct LatLonSpan {
+    const double* lat;
+    const double* lon;
+    std::size_t size;
+};
+
+struct MutableLatLonSpan {
+    double* lat;
+    double* lon;
+    std::size_t size;
+};
+
+// Element-wise versions of the scalar functions above. `from` and `to` must have the
+// same size and the output buffers must hold at least that many elements. Results
+// match the scalar functions to within 1e-8 degrees for bearings, 1e-9 degrees for
+// translated coordinates and 1e-8 km for distances. Translated longitudes are compared
+// as arc along the parallel; from within 1e-3 degrees of a pole, where the formula
+// itself loses precision, they agree to 1e-7 degrees of arc (test_coordinates.cpp). The
+// bearing between coincident points is undefined.
+void calculate_bearing_batch(LatLonSpan from, LatLonSpan to, double* bearings);
+void haversine_distance_batch(LatLonSpan from, LatLonSpan to, double* distances);
+
+// Translates every coordinate by the same bearing (degrees) and distance (km), e.g. a
+// whole mission. `out` may alias `coords`.
+void translate_coordinates_batch(LatLonSpan coords, double bearing, double distance, MutableLatLonSpan out);
+
+// True when the batch functions run on the AVX2/FMA kernels instead of the scalar fallback.
+bool geodesy_simd_enabled();
 
 #endif // COORDINATES_H
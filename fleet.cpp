@@ -0,0 +1,265 @@
+#include "fleet.h"
+#include "follow_logic.h"
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <sstream>
+
+namespace {
+
+bool parse_sysid(const std::string& text, uint8_t& sysid) {
+    std::istringstream in(text);
+    int value = 0;
+    if (!(in >> value) || value < 1 || value > 255) {
+        return false;
+    }
+    sysid = static_cast<uint8_t>(value);
+    return true;
+}
+
+} // namespace
+
+bool load_fleet_config(const std::string& path, FleetConfig& config, std::string& error) {
+    std::ifstream file(path);
+    if (!file) {
+        error = "cannot open " + path;
+        return false;
+    }
+
+    std::string line;
+    int line_number = 0;
+    while (std::getline(file, line)) {
+        ++line_number;
+        const auto comment = line.find('#');
+        if (comment != std::string::npos) {
+            line.erase(comment);
+        }
+        std::istringstream in(line);
+        std::string key;
+        if (!(in >> key)) {
+            continue;
+        }
+
+        bool ok = true;
+        if (key == "connection") {
+            std::string url;
+            ok = static_cast<bool>(in >> url);
+            config.connections.push_back(url);
+        } else if (key == "ship_link") {
+            std::string url;
+            ok = static_cast<bool>(in >> url);
+            config.ship_links.push_back(url);
+        } else if (key == "target_stale") {
+            ok = static_cast<bool>(in >> config.target_fusion.stale_intervals) &&
+                 config.target_fusion.stale_intervals > 1;
+            long min_ms;
+            long max_ms;
+            if (ok && in >> min_ms) {
+                ok = min_ms > 0;
+                config.target_fusion.min_stale = std::chrono::milliseconds(min_ms);
+                if (ok && in >> max_ms) {
+                    ok = max_ms >= min_ms;
+                    config.target_fusion.max_stale = std::chrono::milliseconds(max_ms);
+                }
+            }
+        } else if (key == "pair") {
+            PairConfig pair;
+            std::string drone;
+            std::string ship;
+            ok = (in >> pair.name >> drone >> ship) && parse_sysid(drone, pair.drone_sysid) &&
+                 parse_sysid(ship, pair.ship_sysid);
+            float threshold;
+            if (ok && in >> threshold) {
+                pair.threshold_m = threshold;
+            }
+            // Two pairs on one drone would fight over its home through the same command channel.
+            if (ok && pair.drone_sysid == pair.ship_sysid) {
+                error = path + ":" + std::to_string(line_number) + ": pair '" + pair.name +
+                        "' uses sysid " + std::to_string(pair.drone_sysid) + " as both drone and ship";
+                return false;
+            }
+            for (const auto& other : config.pairs) {
+                if (ok && other.drone_sysid == pair.drone_sysid) {
+                    error = path + ":" + std::to_string(line_number) + ": drone sysid " +
+                            std::to_string(pair.drone_sysid) + " already belongs to pair '" + other.name + "'";
+                    return false;
+                }
+            }
+            config.pairs.push_back(pair);
+        } else if (key == "workers") {
+            ok = static_cast<bool>(in >> config.workers);
+        } else if (key == "min_update_interval_ms") {
+            long ms;
+            ok = static_cast<bool>(in >> ms) && ms >= 0;
+            config.min_update_interval = std::chrono::milliseconds(ms);
+        } else if (key == "position_rate_hz") {
+            ok = static_cast<bool>(in >> config.position_rate_hz) && config.position_rate_hz > 0;
+        } else if (key == "rate_control") {
+            ok = (in >> config.rate.min_hz >> config.rate.max_hz) && config.rate.min_hz > 0 &&
+                 config.rate.max_hz >= config.rate.min_hz;
+            double budget;
+            if (ok && in >> budget) {
+                ok = budget > 0;
+                config.rate.link_budget_bytes_s = budget;
+            }
+            config.rate_control = true;
+        } else if (key == "rate_link") {
+            RateLinkConfig link;
+            ok = static_cast<bool>(in >> link.budget_bytes_s) && link.budget_bytes_s > 0;
+            std::string text;
+            while (ok && in >> text) {
+                uint8_t sysid;
+                ok = parse_sysid(text, sysid);
+                link.sysids.push_back(sysid);
+            }
+            ok = ok && !link.sysids.empty();
+            // One vehicle's bytes would count against two budgets.
+            for (const uint8_t sysid : link.sysids) {
+                for (const auto& other : config.rate_links) {
+                    if (ok && std::count(other.sysids.begin(), other.sysids.end(), sysid)) {
+                        error = path + ":" + std::to_string(line_number) + ": sysid " + std::to_string(sysid) +
+                                " is already in another rate_link";
+                        return false;
+                    }
+                }
+            }
+            config.rate_links.push_back(link);
+        } else if (key == "flight_log") {
+            ok = static_cast<bool>(in >> config.flight_log);
+        } else if (key == "latency_export") {
+            ok = static_cast<bool>(in >> config.latency_export);
+            long ms;
+            if (ok && in >> ms) {
+                ok = ms > 0;
+                config.latency_export_interval = std::chrono::milliseconds(ms);
+            }
+        } else {
+            ok = false;
+        }
+
+        if (!ok) {
+            error = path + ":" + std::to_string(line_number) + ": invalid line '" + line + "'";
+            return false;
+        }
+    }
+
+    if (config.connections.empty() || config.pairs.empty()) {
+        error = path + ": needs at least one connection and one pair";
+        return false;
+    }
+    return true;
+}
+
+FleetFollower::FleetFollower(std::vector<PairConfig> pairs, std::chrono::milliseconds min_update_interval,
+                             WorkerPool& pool, HomeSink sink, DecisionSink decision_sink,
+                             std::size_t ship_sources, TargetFusionConfig fusion) :
+    _min_update_interval(min_update_interval),
+    _pool(pool),
+    _sink(std::move(sink)),
+    _decision_sink(std::move(decision_sink))
+{
+    _pairs.reserve(pairs.size());
+    for (auto& config : pairs) {
+        _pairs.emplace_back(new PairState(std::move(config), ship_sources, fusion));
+    }
+}
+
+void FleetFollower::on_ship_position(std::size_t pair, const TargetSample& sample, std::size_t source) {
+    if (_pairs[pair]->ship_position.publish(source, sample)) {
+        schedule(pair);
+    }
+}
+
+void FleetFollower::on_ship_attitude(std::size_t pair, const AttitudeSample& sample) {
+    _pairs[pair]->ship_attitude.publish(sample);
+}
+
+void FleetFollower::on_drone_home(std::size_t pair, const PositionSample& sample) {
+    _pairs[pair]->drone_home.publish(sample);
+    schedule(pair);
+}
+
+void FleetFollower::schedule(std::size_t pair) {
+    PairState& state = *_pairs[pair];
+    if (state.queued.exchange(true)) {
+        return;
+    }
+    // The queued task reads the slots when it runs, so later samples are picked up for free.
+    const auto earliest = WorkerPool::Clock::time_point(
+        std::chrono::nanoseconds(state.last_evaluation_ns.load(std::memory_order_relaxed))) +
+        _min_update_interval;
+    _pool.post_at(std::max(WorkerPool::Clock::now(), earliest), [this, pair]() { evaluate(pair); });
+}
+
+bool FleetFollower::motion(std::size_t pair, double& speed_m_s, double& margin_m) const {
+    const PairState& state = *_pairs[pair];
+    speed_m_s = state.ship_speed_m_s.load(std::memory_order_relaxed);
+    margin_m = state.threshold_margin_m.load(std::memory_order_relaxed);
+    return speed_m_s >= 0;
+}
+
+void FleetFollower::evaluate(std::size_t pair) {
+    const int64_t compute_start_ns = monotonic_ns();
+    PairState& state = *_pairs[pair];
+
+    FusedTarget fused{};
+    PositionSample home;
+    const uint64_t position_version = state.ship_position.version();
+    uint64_t home_version = 0;
+    const bool have_ship = state.ship_position.select(compute_start_ns, fused);
+    const bool have_home = state.drone_home.read(home, home_version);
+    const bool changed = position_version != state.seen_position || home_version != state.seen_home;
+    const PositionSample& ship = fused.position;
+
+    // A copy of a fix already used arriving late on another link is not a new fix, nor is
+    // an older one left on a slower link after the faster one went stale.
+    if (have_ship && (!state.have_fix || source_time_newer(fused.source_time_ms, state.fix_time_ms))) {
+        if (state.have_fix && fused.source != state.fix_source) {
+            state.source_switches.fetch_add(1, std::memory_order_relaxed);
+        }
+        state.estimator.update_position(ship);
+        state.have_fix = true;
+        state.fix_time_ms = fused.source_time_ms;
+        state.fix_source = fused.source;
+    }
+    AttitudeSample attitude;
+    uint64_t attitude_version = 0;
+    if (state.ship_attitude.read(attitude, attitude_version) && attitude_version != state.seen_attitude) {
+        state.estimator.update_attitude(attitude);
+        state.seen_attitude = attitude_version;
+    }
+    state.seen_position = position_version;
+    state.seen_home = home_version;
+
+    if (have_ship && have_home && changed) {
+        const int64_t now_ns = monotonic_ns();
+        state.last_evaluation_ns.store(now_ns, std::memory_order_relaxed);
+        state.evaluations.fetch_add(1, std::memory_order_relaxed);
+
+        const ShipEstimate estimate = state.estimator.predict(now_ns);
+        PositionSample target = ship;
+        target.latitude_deg = estimate.latitude_deg;
+        target.longitude_deg = estimate.longitude_deg;
+
+        const FollowDecision decision = evaluate_follow(target, home, state.config.threshold_m);
+        const int64_t compute_end_ns = monotonic_ns();
+        state.threshold_margin_m.store(std::fabs(state.config.threshold_m - decision.distance_m),
+                                       std::memory_order_relaxed);
+        state.ship_speed_m_s.store(std::hypot(estimate.north_m_s, estimate.east_m_s), std::memory_order_relaxed);
+        if (_decision_sink) {
+            _decision_sink(pair, now_ns, target, decision, estimate.position_sigma_m);
+        }
+        if (state.gate.update(decision, target)) {
+            state.commands.fetch_add(1, std::memory_order_relaxed);
+            _sink(pair, {target.latitude_deg, target.longitude_deg, 0, ship.time_ns, estimate.position_sigma_m,
+                         compute_start_ns, compute_end_ns});
+        }
+    }
+
+    // `queued` stays set while evaluating so a pair never runs on two workers at once.
+    // Samples that landed meanwhile did not schedule anything, so pick them up here.
+    state.queued.store(false);
+    if (state.ship_position.version() != position_version || state.drone_home.version() != home_version) {
+        schedule(pair);
+    }
+}
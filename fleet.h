@@ -0,0 +1,143 @@
+#ifndef FLEET_H
+#define FLEET_H
+
+#include "follow_logic.h"
+#include "home_command_channel.h"
+#include "rate_controller.h"
+#include "ship_estimator.h"
+#include "target_fusion.h"
+#include "telemetry_slot.h"
+#include "worker_pool.h"
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+// One drone whose home follows one ship. Vehicles are identified by MAVLink system id.
+struct PairConfig {
+    std::string name;
+    uint8_t drone_sysid;
+    uint8_t ship_sysid;
+    float threshold_m = 10;
+};
+
+// Vehicles whose telemetry shares one radio, and what that radio carries.
+struct RateLinkConfig {
+    double budget_bytes_s;
+    std::vector<uint8_t> sysids;
+};
+
+struct FleetConfig {
+    std::vector<std::string> connections;
+    // Extra links that carry the ships' telemetry again; each is one more position source.
+    std::vector<std::string> ship_links;
+    TargetFusionConfig target_fusion;
+    std::vector<PairConfig> pairs;
+    std::chrono::milliseconds min_update_interval{200};
+    std::size_t workers = 0;
+    double position_rate_hz = 1.0;
+    // Ship position/attitude rates follow the ship's motion, starting at position_rate_hz.
+    // A ship's link budget comes from its rate_links entry, else from `rate`.
+    bool rate_control = false;
+    RateControllerConfig rate;
+    std::vector<RateLinkConfig> rate_links;
+    std::string flight_log = "flight";
+    std::string latency_export = "file:latency.jsonl";
+    std::chrono::milliseconds latency_export_interval{10000};
+};
+
+// Reads a pairing file. Blank lines and '#' comments are ignored; other lines are
+//   connection <url>
+//   ship_link <url>
+//   target_stale <intervals> [min_ms] [max_ms]
+//   pair <name> <drone_sysid> <ship_sysid> [threshold_m]
+//   workers <count>
+//   min_update_interval_ms <ms>
+//   position_rate_hz <hz>
+//   rate_control <min_hz> <max_hz> [link_budget_bytes_s]
+//   rate_link <budget_bytes_s> <sysid>...
+//   flight_log <path_prefix>
+//   latency_export file:<path>|udp:<host>:<port> [interval_ms]
+// A drone may be in one pair only and is never its own ship. Without a budget a link is
+// not rate-limited; rate_link names the vehicles behind one radio, each in one rate_link.
+bool load_fleet_config(const std::string& path, FleetConfig& config, std::string& error);
+
+// Runs the home-follow rule for every pair on a shared WorkerPool. Telemetry callbacks
+// only publish into the pair's slots and schedule the pair; at most one evaluation per
+// pair is queued at a time and evaluations are spaced by `min_update_interval`. The ship
+// position may come from several links (`ship_sources`); a TargetFusion picks the
+// freshest one, which is then passed through a ShipEstimator and extrapolated to the evaluation time, and
+// each pair's FollowGate decides when a command goes to the sink.
+class FleetFollower {
+public:
+    using HomeSink = std::function<void(std::size_t pair, const HomeCommand& command)>;
+    // Called on the worker after every evaluation, whether or not a command followed.
+    using DecisionSink = std::function<void(std::size_t pair, int64_t time_ns, const PositionSample& target,
+                                            const FollowDecision& decision, double position_sigma_m)>;
+
+    FleetFollower(std::vector<PairConfig> pairs, std::chrono::milliseconds min_update_interval,
+                  WorkerPool& pool, HomeSink sink, DecisionSink decision_sink = nullptr,
+                  std::size_t ship_sources = 1, TargetFusionConfig fusion = {});
+
+    void on_ship_position(std::size_t pair, const TargetSample& sample, std::size_t source = 0);
+    void on_ship_attitude(std::size_t pair, const AttitudeSample& sample);
+    void on_drone_home(std::size_t pair, const PositionSample& sample);
+    // The last command for the pair failed; the next evaluation may command again.
+    void rearm(std::size_t pair) { _pairs[pair]->gate.rearm(); }
+
+    std::size_t size() const { return _pairs.size(); }
+    const PairConfig& pair(std::size_t index) const { return _pairs[index]->config; }
+
+    uint64_t evaluations(std::size_t pair) const { return _pairs[pair]->evaluations.load(); }
+    uint64_t commands(std::size_t pair) const { return _pairs[pair]->commands.load(); }
+    // Times the selected ship position source changed, e.g. because a link went stale.
+    uint64_t source_switches(std::size_t pair) const { return _pairs[pair]->source_switches.load(); }
+    // Estimated ship speed and |threshold - distance| at the last evaluation; false before
+    // the first. Safe from any thread.
+    bool motion(std::size_t pair, double& speed_m_s, double& margin_m) const;
+
+private:
+    struct PairState {
+        PairState(PairConfig pair_config, std::size_t ship_sources, TargetFusionConfig fusion) :
+            config(std::move(pair_config)),
+            ship_position(ship_sources, fusion),
+            gate(config.threshold_m)
+        {}
+
+        PairConfig config;
+        TargetFusion ship_position;
+        TelemetrySlot<AttitudeSample> ship_attitude;
+        TelemetrySlot<PositionSample> drone_home;
+        std::atomic<bool> queued{false};
+        std::atomic<int64_t> last_evaluation_ns{0};
+        uint64_t seen_position = 0;
+        uint64_t seen_home = 0;
+        uint64_t seen_attitude = 0;
+        // Vehicle time of the last fix given to the estimator, and the source it came from.
+        bool have_fix = false;
+        uint32_t fix_time_ms = 0;
+        std::size_t fix_source = 0;
+        ShipEstimator estimator;
+        FollowGate gate;
+        std::atomic<uint64_t> evaluations{0};
+        std::atomic<uint64_t> commands{0};
+        std::atomic<uint64_t> source_switches{0};
+        // Negative until the first evaluation.
+        std::atomic<double> ship_speed_m_s{-1};
+        std::atomic<double> threshold_margin_m{0};
+    };
+
+    void schedule(std::size_t pair);
+    void evaluate(std::size_t pair);
+
+    std::vector<std::unique_ptr<PairState>> _pairs;
+    std::chrono::milliseconds _min_update_interval;
+    WorkerPool& _pool;
+    HomeSink _sink;
+    DecisionSink _decision_sink;
+};
+
+#endif // FLEET_H
@@ -0,0 +1,68 @@
+// Decodes flight recorder segments to CSV on stdout:
+//
+//   flight_log_to_csv flight.0.flog flight.1.flog ... > flight.csv
+
+#include "flight_recorder.h"
+#include <cinttypes>
+#include <cstdio>
+
+namespace {
+
+const char* type_name(uint8_t type) {
+    switch (static_cast<RecordType>(type)) {
+        case RecordType::Position:
+            return "position";
+        case RecordType::Attitude:
+            return "attitude";
+        case RecordType::Home:
+            return "home";
+        case RecordType::Decision:
+            return "decision";
+        case RecordType::HomeCommand:
+            return "home_command";
+        case RecordType::RateChange:
+            return "rate_change";
+    }
+    return "unknown";
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        std::fprintf(stderr, "usage: %s <log.flog>...\n", argv[0]);
+        return 1;
+    }
+
+    // rate_change rows leave the position/attitude columns empty and fill the rate columns,
+    // which are empty for every other type.
+    std::printf("time_ns,type,source_sysid,target_sysid,pair,latitude_deg,longitude_deg,altitude_m,"
+                "roll_deg,pitch_deg,yaw_deg,distance_m,bearing_deg,sigma_m,"
+                "from_hz,to_hz,speed_m_s,margin_m,link_bytes_s\n");
+    bool ok = true;
+    std::vector<FlightRecord> records;
+    for (int i = 1; i < argc; ++i) {
+        records.clear();
+        std::string error;
+        if (!read_flight_log(argv[i], records, error)) {
+            std::fprintf(stderr, "%s\n", error.c_str());
+            ok = false;
+            continue;
+        }
+        for (const FlightRecord& record : records) {
+            if (record.type == static_cast<uint8_t>(RecordType::RateChange)) {
+                const RateRecordFields rate = read_rate_record(record);
+                std::printf("%" PRId64 ",%s,%u,%u,%u,,,,,,,,,,%.3f,%.3f,%.3f,%.3f,%.1f\n", record.time_ns,
+                            type_name(record.type), record.source_sysid, record.target_sysid, record.pair,
+                            rate.from_hz, rate.to_hz, rate.speed_m_s, rate.margin_m, rate.link_bytes_s);
+                continue;
+            }
+            std::printf("%" PRId64 ",%s,%u,%u,%u,%.9f,%.9f,%.3f,%.3f,%.3f,%.3f,%.3f,%.3f,%.3f,,,,,\n",
+                        record.time_ns, type_name(record.type), record.source_sysid, record.target_sysid,
+                        record.pair, record.latitude_deg, record.longitude_deg, record.altitude_m,
+                        record.roll_deg, record.pitch_deg, record.yaw_deg, record.distance_m, record.bearing_deg,
+                        record.sigma_m);
+        }
+    }
+    return ok ? 0 : 1;
+}
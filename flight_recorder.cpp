@@ -0,0 +1,275 @@
+#include "flight_recorder.h"
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+
+FlightRecord make_position_record(RecordType type, uint8_t sysid, const PositionSample& sample) {
+    FlightRecord record{};
+    record.time_ns = sample.time_ns;
+    record.type = static_cast<uint8_t>(type);
+    record.source_sysid = sysid;
+    record.latitude_deg = sample.latitude_deg;
+    record.longitude_deg = sample.longitude_deg;
+    record.altitude_m = sample.relative_altitude_m;
+    return record;
+}
+
+FlightRecord make_attitude_record(uint8_t sysid, const AttitudeSample& sample) {
+    FlightRecord record{};
+    record.time_ns = sample.time_ns;
+    record.type = static_cast<uint8_t>(RecordType::Attitude);
+    record.source_sysid = sysid;
+    record.roll_deg = sample.roll_deg;
+    record.pitch_deg = sample.pitch_deg;
+    record.yaw_deg = sample.yaw_deg;
+    return record;
+}
+
+FlightRecord make_decision_record(uint32_t pair, int64_t time_ns, const PositionSample& target,
+                                  const FollowDecision& decision, double sigma_m) {
+    FlightRecord record{};
+    record.time_ns = time_ns;
+    record.type = static_cast<uint8_t>(RecordType::Decision);
+    record.pair = pair;
+    record.latitude_deg = target.latitude_deg;
+    record.longitude_deg = target.longitude_deg;
+    record.distance_m = static_cast<float>(decision.distance_m);
+    record.bearing_deg = static_cast<float>(decision.bearing_deg);
+    record.sigma_m = static_cast<float>(sigma_m);
+    return record;
+}
+
+FlightRecord make_home_command_record(uint32_t pair, uint8_t target_sysid, int64_t time_ns, double latitude_deg,
+                                      double longitude_deg, float altitude_m, double sigma_m) {
+    FlightRecord record{};
+    record.time_ns = time_ns;
+    record.type = static_cast<uint8_t>(RecordType::HomeCommand);
+    record.pair = pair;
+    record.target_sysid = target_sysid;
+    record.latitude_deg = latitude_deg;
+    record.longitude_deg = longitude_deg;
+    record.altitude_m = altitude_m;
+    record.sigma_m = static_cast<float>(sigma_m);
+    return record;
+}
+
+FlightRecord make_rate_record(uint8_t sysid, int64_t time_ns, double from_hz, double to_hz, double speed_m_s,
+                              double margin_m, double link_bytes_s) {
+    FlightRecord record{};
+    record.time_ns = time_ns;
+    record.type = static_cast<uint8_t>(RecordType::RateChange);
+    record.source_sysid = sysid;
+    // Slot layout for RateChange; read_rate_record() is the only reader.
+    record.roll_deg = static_cast<float>(from_hz);
+    record.pitch_deg = static_cast<float>(to_hz);
+    record.sigma_m = static_cast<float>(speed_m_s);
+    record.distance_m = static_cast<float>(margin_m);
+    record.altitude_m = static_cast<float>(link_bytes_s);
+    return record;
+}
+
+RateRecordFields read_rate_record(const FlightRecord& record) {
+    return {record.roll_deg, record.pitch_deg, record.sigma_m, record.distance_m, record.altitude_m};
+}
+
+bool read_flight_log(const std::string& path, std::vector<FlightRecord>& records, std::string& error) {
+    std::FILE* file = std::fopen(path.c_str(), "rb");
+    if (!file) {
+        error = path + ": cannot open";
+        return false;
+    }
+
+    FlightLogHeader header;
+    if (std::fread(&header, sizeof(header), 1, file) != 1 ||
+        std::memcmp(header.magic, FLIGHT_LOG_MAGIC, sizeof(header.magic)) != 0 ||
+        header.version != FLIGHT_LOG_VERSION || header.record_size != sizeof(FlightRecord)) {
+        error = path + ": not a flight log (or unsupported version)";
+        std::fclose(file);
+        return false;
+    }
+
+    // record_count is only advanced after complete batches, so a log from a crashed run
+    // still reads up to the last committed record.
+    FlightRecord record;
+    for (uint64_t i = 0; i < header.record_count && std::fread(&record, sizeof(record), 1, file) == 1; ++i) {
+        records.push_back(record);
+    }
+    std::fclose(file);
+    return true;
+}
+
+FlightRecorder::FlightRecorder(std::size_t capacity) {
+    std::size_t size = 1;
+    while (size < capacity) {
+        size <<= 1;
+    }
+    _cells.reset(new Cell[size]);
+    _mask = size - 1;
+    for (std::size_t i = 0; i < size; ++i) {
+        _cells[i].sequence.store(i, std::memory_order_relaxed);
+    }
+}
+
+FlightRecorder::~FlightRecorder() {
+    stop();
+}
+
+bool FlightRecorder::start(const std::string& path_prefix, std::size_t segment_bytes, std::size_t max_segments) {
+    if (_running) {
+        return false;
+    }
+    _prefix = path_prefix;
+    _segment_bytes = std::max(segment_bytes, sizeof(FlightLogHeader) + sizeof(FlightRecord));
+    _max_segments = std::max<std::size_t>(max_segments, 1);
+    _segment_index = 0;
+    if (!open_segment()) {
+        return false;
+    }
+    _running = true;
+    _writer = std::thread([this]() { writer_loop(); });
+    return true;
+}
+
+void FlightRecorder::stop() {
+    if (!_running.exchange(false)) {
+        return;
+    }
+    _writer.join();
+    close_segment();
+}
+
+// Bounded MPMC ring (Vyukov); producers claim a cell with one CAS, the writer is the only consumer.
+bool FlightRecorder::record(const FlightRecord& record) {
+    uint64_t pos = _enqueue_pos.load(std::memory_order_relaxed);
+    Cell* cell;
+    while (true) {
+        cell = &_cells[pos & _mask];
+        const uint64_t sequence = cell->sequence.load(std::memory_order_acquire);
+        const int64_t diff = static_cast<int64_t>(sequence) - static_cast<int64_t>(pos);
+        if (diff == 0) {
+            if (_enqueue_pos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                break;
+            }
+        } else if (diff < 0) {
+            _dropped.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        } else {
+            pos = _enqueue_pos.load(std::memory_order_relaxed);
+        }
+    }
+    cell->record = record;
+    cell->sequence.store(pos + 1, std::memory_order_release);
+    return true;
+}
+
+bool FlightRecorder::pop(FlightRecord& record) {
+    Cell* cell = &_cells[_dequeue_pos & _mask];
+    const uint64_t sequence = cell->sequence.load(std::memory_order_acquire);
+    if (sequence != _dequeue_pos + 1) {
+        return false;
+    }
+    record = cell->record;
+    cell->sequence.store(_dequeue_pos + _mask + 1, std::memory_order_release);
+    ++_dequeue_pos;
+    return true;
+}
+
+void FlightRecorder::writer_loop() {
+    FlightRecord record;
+    while (true) {
+        // Read the flag before draining so nothing pushed before stop() is left behind.
+        const bool running = _running.load();
+        std::size_t batch = 0;
+        while (batch < 4096 && pop(record)) {
+            if ((!_map || _used + sizeof(FlightRecord) > _segment_bytes) && !rotate()) {
+                _dropped.fetch_add(1, std::memory_order_relaxed);
+                continue;
+            }
+            std::memcpy(_map + _used, &record, sizeof(FlightRecord));
+            _used += sizeof(FlightRecord);
+            ++batch;
+        }
+        if (_map) {
+            reinterpret_cast<FlightLogHeader*>(_map)->record_count =
+                (_used - sizeof(FlightLogHeader)) / sizeof(FlightRecord);
+        }
+        _written.fetch_add(batch, std::memory_order_relaxed);
+
+        if (batch == 0) {
+            if (!running) {
+                return;
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(2));
+        }
+    }
+}
+
+// Moves on to the next segment. If it cannot be opened, records are dropped and the same
+// segment is retried at most once a second, instead of every record burning an index.
+bool FlightRecorder::rotate() {
+    const auto now = std::chrono::steady_clock::now();
+    if (_map) {
+        close_segment();
+        ++_segment_index;
+    } else if (now < _retry_at) {
+        return false;
+    }
+    if (open_segment()) {
+        return true;
+    }
+    _retry_at = now + std::chrono::seconds(1);
+    return false;
+}
+
+bool FlightRecorder::open_segment() {
+    // Keep only the newest max_segments files.
+    if (_segment_index >= _max_segments) {
+        const std::string old_path = _prefix + "." + std::to_string(_segment_index - _max_segments) + ".flog";
+        std::remove(old_path.c_str());
+    }
+
+    const std::string path = _prefix + "." + std::to_string(_segment_index) + ".flog";
+    _fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (_fd < 0) {
+        return false;
+    }
+    void* map = MAP_FAILED;
+    if (::ftruncate(_fd, static_cast<off_t>(_segment_bytes)) == 0) {
+        map = ::mmap(nullptr, _segment_bytes, PROT_READ | PROT_WRITE, MAP_SHARED, _fd, 0);
+    }
+    if (map == MAP_FAILED) {
+        // Do not leave an empty segment behind.
+        ::close(_fd);
+        _fd = -1;
+        std::remove(path.c_str());
+        return false;
+    }
+    _map = static_cast<unsigned char*>(map);
+
+    FlightLogHeader header{};
+    std::memcpy(header.magic, FLIGHT_LOG_MAGIC, sizeof(header.magic));
+    header.version = FLIGHT_LOG_VERSION;
+    header.record_size = sizeof(FlightRecord);
+    std::memcpy(_map, &header, sizeof(header));
+    _used = sizeof(FlightLogHeader);
+    return true;
+}
+
+void FlightRecorder::close_segment() {
+    if (!_map) {
+        return;
+    }
+    reinterpret_cast<FlightLogHeader*>(_map)->record_count = (_used - sizeof(FlightLogHeader)) / sizeof(FlightRecord);
+    ::munmap(_map, _segment_bytes);
+    _map = nullptr;
+    // Trim the preallocated tail so the file holds exactly the records written.
+    if (::ftruncate(_fd, static_cast<off_t>(_used)) != 0) {
+        std::perror("flight recorder: ftruncate");
+    }
+    ::close(_fd);
+    _fd = -1;
+}
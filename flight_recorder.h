@@ -0,0 +1,134 @@
+#ifndef FLIGHT_RECORDER_H
+#define FLIGHT_RECORDER_H
+
+#include "follow_logic.h"
+#include "telemetry_slot.h"
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+enum class RecordType : uint8_t {
+    Position = 1,     // ship or drone position
+    Attitude = 2,     // ship attitude
+    Home = 3,         // drone home reported by the autopilot
+    Decision = 4,     // distance / bearing computed by the follow rule
+    HomeCommand = 5,  // MAV_CMD_DO_SET_HOME sent
+    RateChange = 6,   // telemetry rate requested from source_sysid, see make_rate_record
+};
+
+// One fixed-size record; which fields are meaningful depends on `type`.
+struct FlightRecord {
+    int64_t time_ns;
+    double latitude_deg;
+    double longitude_deg;
+    float altitude_m;
+    float roll_deg;
+    float pitch_deg;
+    float yaw_deg;
+    float distance_m;
+    float bearing_deg;
+    float sigma_m;
+    uint32_t pair;
+    uint8_t type;
+    uint8_t source_sysid;
+    uint8_t target_sysid;
+    uint8_t reserved[5];
+};
+static_assert(sizeof(FlightRecord) == 64, "FlightRecord is part of the on-disk format");
+
+// Start of every log segment. Records follow at offset sizeof(FlightLogHeader).
+struct FlightLogHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t record_size;
+    uint64_t record_count;
+    uint8_t reserved[40];
+};
+static_assert(sizeof(FlightLogHeader) == 64, "FlightLogHeader is part of the on-disk format");
+
+const char FLIGHT_LOG_MAGIC[8] = {'F', 'L', 'T', 'L', 'O', 'G', '0', '1'};
+const uint32_t FLIGHT_LOG_VERSION = 1;
+
+FlightRecord make_position_record(RecordType type, uint8_t sysid, const PositionSample& sample);
+FlightRecord make_attitude_record(uint8_t sysid, const AttitudeSample& sample);
+// `target` is the (extrapolated) ship position the rule was evaluated against.
+FlightRecord make_decision_record(uint32_t pair, int64_t time_ns, const PositionSample& target,
+                                  const FollowDecision& decision, double sigma_m);
+FlightRecord make_home_command_record(uint32_t pair, uint8_t target_sysid, int64_t time_ns, double latitude_deg,
+                                      double longitude_deg, float altitude_m, double sigma_m);
+// A RateChange record has no position or attitude, so its values are kept in the float
+// slots of the record (see flight_recorder.cpp); always read them through read_rate_record().
+struct RateRecordFields {
+    double from_hz;
+    double to_hz;
+    double speed_m_s;
+    double margin_m;
+    double link_bytes_s;
+};
+FlightRecord make_rate_record(uint8_t sysid, int64_t time_ns, double from_hz, double to_hz, double speed_m_s,
+                              double margin_m, double link_bytes_s);
+RateRecordFields read_rate_record(const FlightRecord& record);
+
+// Appends the committed records of one log segment to `records`.
+bool read_flight_log(const std::string& path, std::vector<FlightRecord>& records, std::string& error);
+
+// Binary flight recorder. record() is lock-free and never blocks, so it is safe to call
+// from MAVSDK callback threads; records go into a bounded ring (dropped and counted when
+// it is full) and a background thread copies them into memory-mapped log segments
+// <prefix>.<n>.flog, rotating after `segment_bytes` and keeping the last `max_segments`.
+class FlightRecorder {
+public:
+    // `capacity` is rounded up to a power of two.
+    explicit FlightRecorder(std::size_t capacity = 1 << 16);
+    ~FlightRecorder();
+
+    FlightRecorder(const FlightRecorder&) = delete;
+    FlightRecorder& operator=(const FlightRecorder&) = delete;
+
+    bool start(const std::string& path_prefix, std::size_t segment_bytes = 64u << 20, std::size_t max_segments = 8);
+    // Drains the ring, finalizes the current segment and joins the writer.
+    void stop();
+
+    bool record(const FlightRecord& record);
+
+    uint64_t dropped() const { return _dropped.load(std::memory_order_relaxed); }
+    uint64_t written() const { return _written.load(std::memory_order_relaxed); }
+
+private:
+    struct Cell {
+        std::atomic<uint64_t> sequence;
+        FlightRecord record;
+    };
+
+    bool pop(FlightRecord& record);
+    void writer_loop();
+    bool open_segment();
+    void close_segment();
+    bool rotate();
+
+    std::unique_ptr<Cell[]> _cells;
+    std::size_t _mask;
+    alignas(64) std::atomic<uint64_t> _enqueue_pos{0};
+    alignas(64) uint64_t _dequeue_pos = 0;
+    alignas(64) std::atomic<uint64_t> _dropped{0};
+    std::atomic<uint64_t> _written{0};
+
+    std::atomic<bool> _running{false};
+    std::thread _writer;
+    std::string _prefix;
+    std::size_t _segment_bytes = 0;
+    std::size_t _max_segments = 0;
+    std::size_t _segment_index = 0;
+    int _fd = -1;
+    unsigned char* _map = nullptr;
+    std::size_t _used = 0;
+    // After a failed open no segment is mapped; the same index is retried from this time on.
+    std::chrono::steady_clock::time_point _retry_at{};
+};
+
+#endif // FLIGHT_RECORDER_H
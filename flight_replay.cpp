@@ -0,0 +1,195 @@
+// Replays flight recorder logs through the follow logic on a virtual clock and prints the
+// resulting command stream as CSV, so two versions of the logic can be diffed offline:
+//
+//   flight_replay [options] flight.0.flog flight.1.flog ... > commands.csv
+//
+//   --ship <sysid> --drone <sysid>   pick one pair out of a fleet log (default: any)
+//   --threshold <m>                  home update threshold (default 10)
+//   --interval-ms <ms>               minimum time between evaluations (default 200)
+//   --closed-loop                    apply commands to the drone home instead of the recorded home
+//   --mission <file>                 also move this mission with the ship, one "lat lon alt" waypoint per line
+//   --repeat <n>                     run the replay n times for timing; the output is printed once
+
+#include "replay.h"
+#include <algorithm>
+#include <chrono>
+#include <cinttypes>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using mavsdk::MissionRaw;
+
+namespace {
+
+// Vehicle stand-in that accepts every mission transfer.
+class ReplayMissionLink : public MissionLink {
+public:
+    bool download(MissionItems& items) override {
+        items = _items;
+        return true;
+    }
+    bool upload(const MissionItems& items) override {
+        _items = items;
+        return true;
+    }
+    bool write_partial(const MissionItems& items, uint16_t start, uint16_t end) override {
+        std::copy(items.begin() + start, items.begin() + end + 1, _items.begin() + start);
+        return true;
+    }
+
+private:
+    MissionItems _items;
+};
+
+bool load_mission(const std::string& path, MissionItems& items) {
+    std::ifstream file(path);
+    if (!file) {
+        return false;
+    }
+    std::string line;
+    while (std::getline(file, line)) {
+        std::istringstream in(line);
+        double latitude_deg;
+        double longitude_deg;
+        float altitude_m;
+        if (!(in >> latitude_deg >> longitude_deg >> altitude_m)) {
+            continue;
+        }
+        MissionRaw::MissionItem item{};
+        item.seq = static_cast<uint32_t>(items.size());
+        item.frame = MAV_FRAME_GLOBAL_RELATIVE_ALT_INT;
+        item.command = MAV_CMD_NAV_WAYPOINT;
+        item.autocontinue = 1;
+        item.x = static_cast<int32_t>(std::lround(latitude_deg * 1e7));
+        item.y = static_cast<int32_t>(std::lround(longitude_deg * 1e7));
+        item.z = altitude_m;
+        items.push_back(item);
+    }
+    return !items.empty();
+}
+
+int usage(const char* name) {
+    std::fprintf(stderr,
+                 "usage: %s [--ship sysid] [--drone sysid] [--threshold m] [--interval-ms ms] "
+                 "[--closed-loop] [--mission file] [--repeat n] <log.flog>...\n",
+                 name);
+    return 1;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    ReplayConfig config;
+    std::string mission_path;
+    int repeat = 1;
+    std::vector<std::string> paths;
+    for (int i = 1; i < argc; ++i) {
+        const bool has_value = i + 1 < argc;
+        if (std::strcmp(argv[i], "--ship") == 0 && has_value) {
+            config.ship_sysid = static_cast<uint8_t>(std::atoi(argv[++i]));
+        } else if (std::strcmp(argv[i], "--drone") == 0 && has_value) {
+            config.drone_sysid = static_cast<uint8_t>(std::atoi(argv[++i]));
+        } else if (std::strcmp(argv[i], "--threshold") == 0 && has_value) {
+            config.threshold_m = static_cast<float>(std::atof(argv[++i]));
+        } else if (std::strcmp(argv[i], "--interval-ms") == 0 && has_value) {
+            config.min_update_interval = std::chrono::milliseconds(std::atol(argv[++i]));
+        } else if (std::strcmp(argv[i], "--closed-loop") == 0) {
+            config.closed_loop_home = true;
+        } else if (std::strcmp(argv[i], "--mission") == 0 && has_value) {
+            mission_path = argv[++i];
+        } else if (std::strcmp(argv[i], "--repeat") == 0 && has_value) {
+            repeat = std::max(1, std::atoi(argv[++i]));
+        } else if (argv[i][0] == '-') {
+            return usage(argv[0]);
+        } else {
+            paths.push_back(argv[i]);
+        }
+    }
+    if (paths.empty()) {
+        return usage(argv[0]);
+    }
+
+    std::vector<FlightRecord> records;
+    for (const auto& path : paths) {
+        std::string error;
+        if (!read_flight_log(path, records, error)) {
+            std::fprintf(stderr, "%s\n", error.c_str());
+            return 1;
+        }
+    }
+    // Callbacks on different threads can land in the ring slightly out of order.
+    std::stable_sort(records.begin(), records.end(),
+                     [](const FlightRecord& a, const FlightRecord& b) { return a.time_ns < b.time_ns; });
+
+    MissionItems mission;
+    ShipPose mission_origin{};
+    if (!mission_path.empty()) {
+        if (!load_mission(mission_path, mission)) {
+            std::fprintf(stderr, "%s: no waypoints\n", mission_path.c_str());
+            return 1;
+        }
+        // The mission is taken to be planned around the first home the drone reported,
+        // with the ship on its first recorded heading.
+        const auto first_home = std::find_if(records.begin(), records.end(), [&config](const FlightRecord& record) {
+            return record.type == static_cast<uint8_t>(RecordType::Home) &&
+                   (config.drone_sysid == 0 || record.source_sysid == config.drone_sysid);
+        });
+        if (first_home == records.end()) {
+            std::fprintf(stderr, "no drone home in the log to anchor the mission\n");
+            return 1;
+        }
+        const auto first_attitude = std::find_if(records.begin(), records.end(), [&config](const FlightRecord& record) {
+            return record.type == static_cast<uint8_t>(RecordType::Attitude) &&
+                   (config.ship_sysid == 0 || record.source_sysid == config.ship_sysid);
+        });
+        mission_origin = {first_home->latitude_deg, first_home->longitude_deg,
+                          first_attitude != records.end() ? first_attitude->yaw_deg : 0.0};
+    }
+
+    std::vector<ReplayCommand> commands;
+    ReplayStats stats;
+    double elapsed_s = 0;
+    for (int run = 0; run < repeat; ++run) {
+        commands.clear();
+        ReplayMissionLink mission_link;
+        MissionSync mission_sync(mission_link);
+        mission_sync.set_base(mission);
+
+        ReplayEngine engine(config, [&commands](const ReplayCommand& command) { commands.push_back(command); });
+        if (!mission.empty()) {
+            engine.set_mission(&mission_sync, mission_origin);
+        }
+
+        const auto start = std::chrono::steady_clock::now();
+        for (const FlightRecord& record : records) {
+            engine.feed(record);
+        }
+        engine.finish();
+        elapsed_s += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        stats = engine.stats();
+    }
+
+    std::printf("time_ns,command,latitude_deg,longitude_deg,altitude_m,distance_m,bearing_deg,sigma_m,items_sent\n");
+    for (const ReplayCommand& command : commands) {
+        std::printf("%" PRId64 ",%s,%.9f,%.9f,%.3f,%.3f,%.6f,%.3f,%zu\n", command.time_ns,
+                    command.type == ReplayCommand::Type::Home ? "home" : "waypoints", command.latitude_deg,
+                    command.longitude_deg, command.altitude_m, command.distance_m, command.bearing_deg,
+                    command.position_sigma_m, command.items_sent);
+    }
+
+    const double per_run_s = elapsed_s / repeat;
+    std::fprintf(stderr,
+                 "records: %" PRIu64 ", evaluations: %" PRIu64 ", home commands: %" PRIu64 " (recorded %" PRIu64
+                 "), waypoint updates: %" PRIu64 "\n"
+                 "replay: %.3f ms per run, %.0f decisions/s, %.0f records/s\n",
+                 stats.records, stats.evaluations, stats.home_commands, stats.recorded_home_commands,
+                 stats.waypoint_updates, per_run_s * 1e3, stats.evaluations / per_run_s,
+                 stats.records / per_run_s);
+    return 0;
+}
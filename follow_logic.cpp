@@ -0,0 +1,39 @@
+#include "follow_logic.h"
+
+FollowDecision evaluate_follow(const PositionSample& ship, const PositionSample& home, float threshold_m) {
+    const FollowGeodesy frame(home.latitude_deg, home.longitude_deg);
+
+    FollowDecision decision;
+    decision.distance_m = frame.distance_m(ship.latitude_deg, ship.longitude_deg);
+    decision.bearing_deg = frame.bearing_deg(ship.latitude_deg, ship.longitude_deg);
+    decision.update_home = decision.distance_m >= threshold_m;
+    return decision;
+}
+
+FollowGate::FollowGate(float threshold_m, float release_ratio) :
+    _threshold_m(threshold_m),
+    _release_m(threshold_m * release_ratio)
+{}
+
+bool FollowGate::update(const FollowDecision& decision, const PositionSample& target) {
+    if (_rearm.exchange(false, std::memory_order_relaxed)) {
+        _have_last = false;
+    }
+    if (!_following) {
+        if (decision.distance_m < _threshold_m) {
+            return false;
+        }
+        _following = true;
+        _have_last = false;
+    } else if (decision.distance_m < _release_m) {
+        _following = false;
+        return false;
+    }
+
+    if (_have_last && _last.distance_m(target.latitude_deg, target.longitude_deg) < _release_m) {
+        return false;
+    }
+    _last = FollowGeodesy(target.latitude_deg, target.longitude_deg);
+    _have_last = true;
+    return true;
+}
@@ -0,0 +1,53 @@
+#ifndef FOLLOW_LOGIC_H
+#define FOLLOW_LOGIC_H
+
+#include "geodesy.h"
+#include "telemetry_slot.h"
+#include <atomic>
+
+// Result of comparing the ship position with the drone's current home.
+struct FollowDecision {
+    double distance_m;
+    double bearing_deg;
+    bool update_home;
+};
+
+// Ship and home are a few km apart at most; half a metre out to 10 km is plenty against
+// a 10 m threshold and selects the flat-earth tier. Farther apart it is less accurate but
+// still far above the threshold, so the decision does not change.
+using FollowGeodesy = Geodesy<cheapest_geodesy_tier<double>(0.5, 10000), double>;
+
+// The home-follow rule shared by the single-pair loop, fleet mode and replay: move the
+// home onto the ship once it is at least `threshold_m` away.
+FollowDecision evaluate_follow(const PositionSample& ship, const PositionSample& home, float threshold_m);
+
+// Hysteresis on top of evaluate_follow, so the home does not chatter while the ship sits
+// near the threshold or while the drone has not reported the new home yet. The gate
+// engages when the distance reaches the threshold and then asks for a new command only
+// once the target has moved `release_ratio * threshold` from the last one commanded. It
+// disengages when the reported home is back within that release distance, and only then
+// can the threshold trigger again. One gate per pair, used by whoever evaluates the pair.
+class FollowGate {
+public:
+    explicit FollowGate(float threshold_m, float release_ratio = 0.5f);
+
+    // True when a home command to `target` is due.
+    bool update(const FollowDecision& decision, const PositionSample& target);
+
+    // Forgets the last commanded target, e.g. after the command for it failed, so the next
+    // update commands again. Safe to call from any thread.
+    void rearm() { _rearm.store(true, std::memory_order_relaxed); }
+
+    bool following() const { return _following; }
+
+private:
+    float _threshold_m;
+    float _release_m;
+    bool _following = false;
+    bool _have_last = false;
+    // Last commanded target, kept as a frame so the distance to it needs no trig.
+    FollowGeodesy _last{0, 0};
+    std::atomic<bool> _rearm{false};
+};
+
+#endif // FOLLOW_LOGIC_H
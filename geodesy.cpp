@@ -0,0 +1,204 @@
+#include "geodesy.h"
+
+namespace {
+
+using namespace geodesy_detail;
+
+const double WGS84_B = WGS84_A * (1 - WGS84_F);
+const int VINCENTY_MAX_ITERATIONS = 200;
+const double VINCENTY_TOLERANCE = 1e-12;
+
+// Series coefficients A and B of Vincenty's formulae for u^2.
+void vincenty_series(double u2, double& a, double& b) {
+    a = 1 + u2 / 16384 * (4096 + u2 * (-768 + u2 * (320 - 175 * u2)));
+    b = u2 / 1024 * (256 + u2 * (-128 + u2 * (74 - 47 * u2)));
+}
+
+double vincenty_delta_sigma(double b, double sin_sigma, double cos_sigma, double cos_2sigma_m) {
+    const double c2 = cos_2sigma_m * cos_2sigma_m;
+    return b * sin_sigma *
+           (cos_2sigma_m + b / 4 *
+                               (cos_sigma * (-1 + 2 * c2) -
+                                b / 6 * cos_2sigma_m * (-3 + 4 * sin_sigma * sin_sigma) * (-3 + 4 * c2)));
+}
+
+} // namespace
+
+template <typename T>
+Geodesy<GeodesyTier::Spherical, T>::Geodesy(double origin_lat_deg, double origin_lon_deg) :
+    _lat_deg(origin_lat_deg),
+    _lon_deg(origin_lon_deg),
+    _sin_lat(static_cast<T>(std::sin(origin_lat_deg * DEG_TO_RAD))),
+    _cos_lat(static_cast<T>(std::cos(origin_lat_deg * DEG_TO_RAD)))
+{}
+
+template <typename T>
+T Geodesy<GeodesyTier::Spherical, T>::distance_m(double lat_deg, double lon_deg) const {
+    const T dlat = static_cast<T>((lat_deg - _lat_deg) * DEG_TO_RAD);
+    const T dlon = static_cast<T>(wrap_lon_delta(lon_deg - _lon_deg) * DEG_TO_RAD);
+    const T sin_half_dlat = std::sin(dlat / 2);
+    const T sin_half_dlon = std::sin(dlon / 2);
+    const T cos_lat = std::cos(static_cast<T>(lat_deg * DEG_TO_RAD));
+    const T a = sin_half_dlat * sin_half_dlat + _cos_lat * cos_lat * sin_half_dlon * sin_half_dlon;
+    return static_cast<T>(SPHERE_RADIUS_M) * 2 * std::atan2(std::sqrt(a), std::sqrt(1 - a));
+}
+
+template <typename T>
+T Geodesy<GeodesyTier::Spherical, T>::bearing_deg(double lat_deg, double lon_deg) const {
+    const T dlat = static_cast<T>((lat_deg - _lat_deg) * DEG_TO_RAD);
+    const T dlon = static_cast<T>(wrap_lon_delta(lon_deg - _lon_deg) * DEG_TO_RAD);
+    const T cos_lat = std::cos(static_cast<T>(lat_deg * DEG_TO_RAD));
+    const T sin_half_dlon = std::sin(dlon / 2);
+    const T x = cos_lat * std::sin(dlon);
+    // cos(lat1) sin(lat2) - sin(lat1) cos(lat2) cos(dlon), rewritten around dlat so short
+    // distances do not cancel (matters for float).
+    const T y = std::sin(dlat) + 2 * _sin_lat * cos_lat * sin_half_dlon * sin_half_dlon;
+    return normalize_bearing(static_cast<T>(std::atan2(x, y) * RAD_TO_DEG));
+}
+
+template <typename T>
+void Geodesy<GeodesyTier::Spherical, T>::destination(T bearing_deg, T distance_m, double& lat_deg,
+                                                     double& lon_deg) const {
+    const T bearing = bearing_deg * static_cast<T>(DEG_TO_RAD);
+    const T angular = distance_m / static_cast<T>(SPHERE_RADIUS_M);
+    const T sin_angular = std::sin(angular);
+    const T cos_angular = std::cos(angular);
+    const T sin_lat = _sin_lat * cos_angular + _cos_lat * sin_angular * std::cos(bearing);
+    const T dlon = std::atan2(std::sin(bearing) * sin_angular * _cos_lat, cos_angular - _sin_lat * sin_lat);
+    lat_deg = std::asin(sin_lat) * RAD_TO_DEG;
+    lon_deg = wrap_lon_delta(_lon_deg + dlon * RAD_TO_DEG);
+}
+
+template <typename T>
+Geodesy<GeodesyTier::Wgs84, T>::Geodesy(double origin_lat_deg, double origin_lon_deg) :
+    _lat_deg(origin_lat_deg),
+    _lon_deg(origin_lon_deg)
+{
+    const double u = std::atan((1 - WGS84_F) * std::tan(origin_lat_deg * DEG_TO_RAD));
+    _sin_u = std::sin(u);
+    _cos_u = std::cos(u);
+}
+
+template <typename T>
+bool Geodesy<GeodesyTier::Wgs84, T>::inverse(double lat_deg, double lon_deg, double& distance_m,
+                                             double& bearing_deg) const {
+    const double l = wrap_lon_delta(lon_deg - _lon_deg) * DEG_TO_RAD;
+    const double u2 = std::atan((1 - WGS84_F) * std::tan(lat_deg * DEG_TO_RAD));
+    const double sin_u2 = std::sin(u2);
+    const double cos_u2 = std::cos(u2);
+
+    double lambda = l;
+    double sin_lambda = 0;
+    double cos_lambda = 1;
+    double sin_sigma = 0;
+    double cos_sigma = 1;
+    double sigma = 0;
+    double cos2_alpha = 1;
+    double cos_2sigma_m = 0;
+    int iteration = 0;
+    for (; iteration < VINCENTY_MAX_ITERATIONS; ++iteration) {
+        sin_lambda = std::sin(lambda);
+        cos_lambda = std::cos(lambda);
+        const double a = cos_u2 * sin_lambda;
+        const double b = _cos_u * sin_u2 - _sin_u * cos_u2 * cos_lambda;
+        sin_sigma = std::sqrt(a * a + b * b);
+        if (sin_sigma == 0) {
+            distance_m = 0;
+            bearing_deg = 0;
+            return true;
+        }
+        cos_sigma = _sin_u * sin_u2 + _cos_u * cos_u2 * cos_lambda;
+        sigma = std::atan2(sin_sigma, cos_sigma);
+        const double sin_alpha = _cos_u * cos_u2 * sin_lambda / sin_sigma;
+        cos2_alpha = 1 - sin_alpha * sin_alpha;
+        // On the equator cos2_alpha is 0 and the term drops out.
+        cos_2sigma_m = cos2_alpha != 0 ? cos_sigma - 2 * _sin_u * sin_u2 / cos2_alpha : 0;
+        const double c = WGS84_F / 16 * cos2_alpha * (4 + WGS84_F * (4 - 3 * cos2_alpha));
+        const double previous = lambda;
+        lambda = l + (1 - c) * WGS84_F * sin_alpha *
+                         (sigma + c * sin_sigma * (cos_2sigma_m + c * cos_sigma * (-1 + 2 * cos_2sigma_m * cos_2sigma_m)));
+        if (std::fabs(lambda - previous) < VINCENTY_TOLERANCE) {
+            break;
+        }
+    }
+    if (iteration == VINCENTY_MAX_ITERATIONS) {
+        return false;
+    }
+
+    const double u_sq = cos2_alpha * (WGS84_A * WGS84_A - WGS84_B * WGS84_B) / (WGS84_B * WGS84_B);
+    double series_a;
+    double series_b;
+    vincenty_series(u_sq, series_a, series_b);
+    distance_m = WGS84_B * series_a * (sigma - vincenty_delta_sigma(series_b, sin_sigma, cos_sigma, cos_2sigma_m));
+    bearing_deg = normalize_bearing(
+        std::atan2(cos_u2 * sin_lambda, _cos_u * sin_u2 - _sin_u * cos_u2 * cos_lambda) * RAD_TO_DEG);
+    return true;
+}
+
+template <typename T>
+double Geodesy<GeodesyTier::Wgs84, T>::distance_m(double lat_deg, double lon_deg) const {
+    double distance;
+    double bearing;
+    if (!inverse(lat_deg, lon_deg, distance, bearing)) {
+        return Geodesy<GeodesyTier::Spherical, double>(_lat_deg, _lon_deg).distance_m(lat_deg, lon_deg);
+    }
+    return distance;
+}
+
+template <typename T>
+double Geodesy<GeodesyTier::Wgs84, T>::bearing_deg(double lat_deg, double lon_deg) const {
+    double distance;
+    double bearing;
+    if (!inverse(lat_deg, lon_deg, distance, bearing)) {
+        return Geodesy<GeodesyTier::Spherical, double>(_lat_deg, _lon_deg).bearing_deg(lat_deg, lon_deg);
+    }
+    return bearing;
+}
+
+template <typename T>
+void Geodesy<GeodesyTier::Wgs84, T>::destination(double bearing_deg, double distance_m, double& lat_deg,
+                                                 double& lon_deg) const {
+    const double alpha1 = bearing_deg * DEG_TO_RAD;
+    const double sin_alpha1 = std::sin(alpha1);
+    const double cos_alpha1 = std::cos(alpha1);
+    const double sigma1 = std::atan2(_sin_u / _cos_u, cos_alpha1);
+    const double sin_alpha = _cos_u * sin_alpha1;
+    const double cos2_alpha = 1 - sin_alpha * sin_alpha;
+    const double u_sq = cos2_alpha * (WGS84_A * WGS84_A - WGS84_B * WGS84_B) / (WGS84_B * WGS84_B);
+    double series_a;
+    double series_b;
+    vincenty_series(u_sq, series_a, series_b);
+
+    const double sigma0 = distance_m / (WGS84_B * series_a);
+    double sigma = sigma0;
+    double sin_sigma = std::sin(sigma);
+    double cos_sigma = std::cos(sigma);
+    double cos_2sigma_m = std::cos(2 * sigma1 + sigma);
+    for (int iteration = 0; iteration < VINCENTY_MAX_ITERATIONS; ++iteration) {
+        cos_2sigma_m = std::cos(2 * sigma1 + sigma);
+        sin_sigma = std::sin(sigma);
+        cos_sigma = std::cos(sigma);
+        const double previous = sigma;
+        sigma = sigma0 + vincenty_delta_sigma(series_b, sin_sigma, cos_sigma, cos_2sigma_m);
+        if (std::fabs(sigma - previous) < VINCENTY_TOLERANCE) {
+            break;
+        }
+    }
+    sin_sigma = std::sin(sigma);
+    cos_sigma = std::cos(sigma);
+    cos_2sigma_m = std::cos(2 * sigma1 + sigma);
+
+    const double tmp = _sin_u * sin_sigma - _cos_u * cos_sigma * cos_alpha1;
+    const double lat = std::atan2(_sin_u * cos_sigma + _cos_u * sin_sigma * cos_alpha1,
+                                  (1 - WGS84_F) * std::sqrt(sin_alpha * sin_alpha + tmp * tmp));
+    const double lambda = std::atan2(sin_sigma * sin_alpha1, _cos_u * cos_sigma - _sin_u * sin_sigma * cos_alpha1);
+    const double c = WGS84_F / 16 * cos2_alpha * (4 + WGS84_F * (4 - 3 * cos2_alpha));
+    const double l = lambda - (1 - c) * WGS84_F * sin_alpha *
+                                  (sigma + c * sin_sigma * (cos_2sigma_m + c * cos_sigma * (-1 + 2 * cos_2sigma_m * cos_2sigma_m)));
+    lat_deg = lat * RAD_TO_DEG;
+    lon_deg = wrap_lon_delta(_lon_deg + l * RAD_TO_DEG);
+}
+
+template class Geodesy<GeodesyTier::Spherical, float>;
+template class Geodesy<GeodesyTier::Spherical, double>;
+template class Geodesy<GeodesyTier::Wgs84, double>;
@@ -0,0 +1,292 @@
+#ifndef GEODESY_H
+#define GEODESY_H
+
+#include <cmath>
+#include <type_traits>
+
+// Geodesy with a selectable cost/accuracy tier. Every tier works relative to an origin
+// given at construction, so whatever depends only on the origin is computed once:
+//
+//   Geodesy<GeodesyTier::LocalTangentPlane, double> frame(home_lat, home_lon);
+//   const double d = frame.distance_m(ship_lat, ship_lon);
+//
+// Latitudes and longitudes are always double degrees: a float holds a latitude only to
+// ~0.5 m. T is the type the distances, bearings and ENU offsets are computed and
+// returned in. Only float and double are provided.
+//
+// Bearings are clockwise from true north in [0, 360), at the origin.
+enum class GeodesyTier {
+    // Equirectangular projection onto the plane tangent at the origin, scaled with the
+    // WGS84 radii of curvature there. cos(latitude) is expanded around the cached
+    // sin/cos of the origin, so distances need no trig at all. For short ranges only.
+    LocalTangentPlane,
+    // Haversine on a sphere of 6371 km, like coordinates.h.
+    Spherical,
+    // Vincenty's formulae on the WGS84 ellipsoid.
+    Wgs84,
+};
+
+// Worst error against the WGS84 geodesic for points within `max_range_m` of the origin
+// and at |latitude| <= 80 degrees, measured over random point pairs with the Wgs84 tier
+// as reference (rounded up). The relative term dominates: the flat-earth tier is off by
+// ~1e-6 at 1 km and 2e-5 at 20 km, the sphere by up to 0.57% at any range. Beyond
+// max_range_m the tangent plane breaks down, and spherical bearings near the antipode
+// are off by tens of degrees. test_geodesy.cpp checks these bounds.
+struct GeodesyErrorBound {
+    double absolute_m;
+    // Fraction of the distance.
+    double relative;
+    double bearing_deg;
+    double max_range_m;
+
+    constexpr double distance_error_m(double distance_m) const { return absolute_m + relative * distance_m; }
+};
+
+template <GeodesyTier Tier, typename T>
+struct GeodesyBounds;
+
+template <>
+struct GeodesyBounds<GeodesyTier::LocalTangentPlane, double> {
+    static constexpr GeodesyErrorBound value{1e-6, 2e-5, 5e-4, 20000};
+};
+template <>
+struct GeodesyBounds<GeodesyTier::LocalTangentPlane, float> {
+    static constexpr GeodesyErrorBound value{1e-6, 2.1e-5, 5e-4, 20000};
+};
+template <>
+struct GeodesyBounds<GeodesyTier::Spherical, double> {
+    static constexpr GeodesyErrorBound value{1e-6, 5.7e-3, 0.2, 1.0e7};
+};
+template <>
+struct GeodesyBounds<GeodesyTier::Spherical, float> {
+    static constexpr GeodesyErrorBound value{1e-2, 5.7e-3, 0.2, 1.0e7};
+};
+template <>
+struct GeodesyBounds<GeodesyTier::Wgs84, double> {
+    static constexpr GeodesyErrorBound value{1e-3, 0, 1e-6, 1.99e7};
+};
+template <>
+struct GeodesyBounds<GeodesyTier::Wgs84, float> {
+    static constexpr GeodesyErrorBound value{1e-3, 1.2e-7, 3e-5, 1.99e7};
+};
+
+// Cheapest tier whose distance error stays within `budget_m` out to `range_m`, e.g.
+//   using FollowGeodesy = Geodesy<cheapest_geodesy_tier<double>(0.1, 10000), double>;
+template <typename T>
+constexpr GeodesyTier cheapest_geodesy_tier(double budget_m, double range_m) {
+    using Ltp = GeodesyBounds<GeodesyTier::LocalTangentPlane, T>;
+    using Sphere = GeodesyBounds<GeodesyTier::Spherical, T>;
+    return range_m <= Ltp::value.max_range_m && Ltp::value.distance_error_m(range_m) <= budget_m
+               ? GeodesyTier::LocalTangentPlane
+           : range_m <= Sphere::value.max_range_m && Sphere::value.distance_error_m(range_m) <= budget_m
+               ? GeodesyTier::Spherical
+               : GeodesyTier::Wgs84;
+}
+
+namespace geodesy_detail {
+
+constexpr double PI = 3.14159265358979323846;
+constexpr double DEG_TO_RAD = PI / 180.0;
+constexpr double RAD_TO_DEG = 180.0 / PI;
+constexpr double WGS84_A = 6378137.0;
+constexpr double WGS84_F = 1 / 298.257223563;
+constexpr double WGS84_E2 = WGS84_F * (2 - WGS84_F);
+// EARTH_RADIUS of coordinates.cpp, in meters.
+constexpr double SPHERE_RADIUS_M = 6371000.0;
+
+// Longitude (difference) folded into [-180, 180].
+inline double wrap_lon_delta(double delta_deg) {
+    if (delta_deg > 180) {
+        return delta_deg - 360;
+    }
+    if (delta_deg < -180) {
+        return delta_deg + 360;
+    }
+    return delta_deg;
+}
+
+template <typename T>
+T normalize_bearing(T bearing_deg) {
+    return bearing_deg < 0 ? bearing_deg + T(360) : bearing_deg;
+}
+
+} // namespace geodesy_detail
+
+template <GeodesyTier Tier, typename T>
+class Geodesy;
+
+template <typename T>
+class Geodesy<GeodesyTier::LocalTangentPlane, T> {
+    static_assert(std::is_floating_point<T>::value, "Geodesy needs float or double");
+
+public:
+    static constexpr GeodesyErrorBound error_bound = GeodesyBounds<GeodesyTier::LocalTangentPlane, T>::value;
+
+    Geodesy(double origin_lat_deg, double origin_lon_deg) :
+        _lat_deg(origin_lat_deg),
+        _lon_deg(origin_lon_deg)
+    {
+        using namespace geodesy_detail;
+        const double phi = origin_lat_deg * DEG_TO_RAD;
+        const double sin_phi = std::sin(phi);
+        const double w2 = 1 - WGS84_E2 * sin_phi * sin_phi;
+        _sin_lat = static_cast<T>(sin_phi);
+        _cos_lat = static_cast<T>(std::cos(phi));
+        _meridian_m = static_cast<T>(WGS84_A * (1 - WGS84_E2) / (w2 * std::sqrt(w2)));
+        _normal_m = static_cast<T>(WGS84_A / std::sqrt(w2));
+        _inverse_meridian = 1 / _meridian_m;
+    }
+
+    double origin_lat_deg() const { return _lat_deg; }
+    double origin_lon_deg() const { return _lon_deg; }
+
+    void to_enu(double lat_deg, double lon_deg, T& east_m, T& north_m) const {
+        using namespace geodesy_detail;
+        // The differences are taken in double, so a float T only rounds the small offsets.
+        const T dlat = static_cast<T>((lat_deg - _lat_deg) * DEG_TO_RAD);
+        const T dlon = static_cast<T>(wrap_lon_delta(lon_deg - _lon_deg) * DEG_TO_RAD);
+        north_m = _meridian_m * dlat;
+        east_m = _normal_m * cos_mid_lat(dlat) * dlon;
+    }
+
+    void from_enu(T east_m, T north_m, double& lat_deg, double& lon_deg) const {
+        using namespace geodesy_detail;
+        const T dlat = north_m * _inverse_meridian;
+        const T dlon = east_m / (_normal_m * cos_mid_lat(dlat));
+        lat_deg = _lat_deg + dlat * RAD_TO_DEG;
+        lon_deg = wrap_lon_delta(_lon_deg + dlon * RAD_TO_DEG);
+    }
+
+    T distance_m(double lat_deg, double lon_deg) const {
+        T east;
+        T north;
+        to_enu(lat_deg, lon_deg, east, north);
+        return std::sqrt(east * east + north * north);
+    }
+
+    T bearing_deg(double lat_deg, double lon_deg) const {
+        using namespace geodesy_detail;
+        T east;
+        T north;
+        to_enu(lat_deg, lon_deg, east, north);
+        // The plane gives the course at the midpoint; the meridians converge by about
+        // dlon * sin(lat) on the way, so the course at the origin is half that less.
+        const T dlon = static_cast<T>(wrap_lon_delta(lon_deg - _lon_deg) * DEG_TO_RAD);
+        return normalize_bearing(static_cast<T>((std::atan2(east, north) - dlon * _sin_lat / 2) * RAD_TO_DEG));
+    }
+
+    void destination(T bearing_deg, T distance_m, double& lat_deg, double& lon_deg) const {
+        using namespace geodesy_detail;
+        // Inverse of bearing_deg(): the correction depends on the dlon being solved for, so
+        // iterate; each pass shrinks the error by a factor of dlon * sin(lat) / 2.
+        const T bearing = bearing_deg * static_cast<T>(DEG_TO_RAD);
+        T course = bearing;
+        for (int pass = 0; pass < 3; ++pass) {
+            from_enu(distance_m * std::sin(course), distance_m * std::cos(course), lat_deg, lon_deg);
+            course = bearing + static_cast<T>(wrap_lon_delta(lon_deg - _lon_deg) * DEG_TO_RAD) * _sin_lat / 2;
+        }
+        from_enu(distance_m * std::sin(course), distance_m * std::cos(course), lat_deg, lon_deg);
+    }
+
+private:
+    // cos of the latitude halfway to a point `dlat` radians north of the origin, from the
+    // cached sin/cos (second-order expansion; the dropped terms are below 1e-10).
+    T cos_mid_lat(T dlat) const {
+        const T half = dlat / 2;
+        return _cos_lat * (1 - half * half / 2) - _sin_lat * half;
+    }
+
+    double _lat_deg;
+    double _lon_deg;
+    T _sin_lat;
+    T _cos_lat;
+    // Meridian and prime-vertical radii of curvature at the origin.
+    T _meridian_m;
+    T _normal_m;
+    T _inverse_meridian;
+};
+
+template <typename T>
+class Geodesy<GeodesyTier::Spherical, T> {
+    static_assert(std::is_floating_point<T>::value, "Geodesy needs float or double");
+
+public:
+    static constexpr GeodesyErrorBound error_bound = GeodesyBounds<GeodesyTier::Spherical, T>::value;
+
+    Geodesy(double origin_lat_deg, double origin_lon_deg);
+
+    double origin_lat_deg() const { return _lat_deg; }
+    double origin_lon_deg() const { return _lon_deg; }
+
+    T distance_m(double lat_deg, double lon_deg) const;
+    T bearing_deg(double lat_deg, double lon_deg) const;
+    void destination(T bearing_deg, T distance_m, double& lat_deg, double& lon_deg) const;
+
+private:
+    double _lat_deg;
+    double _lon_deg;
+    T _sin_lat;
+    T _cos_lat;
+};
+
+template <typename T>
+class Geodesy<GeodesyTier::Wgs84, T> {
+    static_assert(std::is_same<T, double>::value, "Geodesy<Wgs84> is defined for double, float is specialized");
+
+public:
+    static constexpr GeodesyErrorBound error_bound = GeodesyBounds<GeodesyTier::Wgs84, double>::value;
+
+    Geodesy(double origin_lat_deg, double origin_lon_deg);
+
+    double origin_lat_deg() const { return _lat_deg; }
+    double origin_lon_deg() const { return _lon_deg; }
+
+    // Nearly antipodal points (where the iteration does not converge) fall back to the
+    // Spherical tier.
+    double distance_m(double lat_deg, double lon_deg) const;
+    double bearing_deg(double lat_deg, double lon_deg) const;
+    void destination(double bearing_deg, double distance_m, double& lat_deg, double& lon_deg) const;
+
+private:
+    bool inverse(double lat_deg, double lon_deg, double& distance_m, double& bearing_deg) const;
+
+    double _lat_deg;
+    double _lon_deg;
+    // Reduced latitude of the origin.
+    double _sin_u;
+    double _cos_u;
+};
+
+// Vincenty's iteration does not converge reliably in single precision, so the float
+// variant runs the double solver and only rounds the results.
+template <>
+class Geodesy<GeodesyTier::Wgs84, float> {
+public:
+    static constexpr GeodesyErrorBound error_bound = GeodesyBounds<GeodesyTier::Wgs84, float>::value;
+
+    Geodesy(double origin_lat_deg, double origin_lon_deg) :
+        _solver(origin_lat_deg, origin_lon_deg)
+    {}
+
+    double origin_lat_deg() const { return _solver.origin_lat_deg(); }
+    double origin_lon_deg() const { return _solver.origin_lon_deg(); }
+
+    float distance_m(double lat_deg, double lon_deg) const {
+        return static_cast<float>(_solver.distance_m(lat_deg, lon_deg));
+    }
+    float bearing_deg(double lat_deg, double lon_deg) const {
+        return static_cast<float>(_solver.bearing_deg(lat_deg, lon_deg));
+    }
+    void destination(float bearing_deg, float distance_m, double& lat_deg, double& lon_deg) const {
+        _solver.destination(bearing_deg, distance_m, lat_deg, lon_deg);
+    }
+
+private:
+    Geodesy<GeodesyTier::Wgs84, double> _solver;
+};
+
+extern template class Geodesy<GeodesyTier::Spherical, float>;
+extern template class Geodesy<GeodesyTier::Spherical, double>;
+extern template class Geodesy<GeodesyTier::Wgs84, double>;
+
+#endif // GEODESY_H
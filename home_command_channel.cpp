@@ -0,0 +1,143 @@
+#include "home_command_channel.h"
+#include "telemetry_slot.h"
+#include <algorithm>
+#include <mavsdk/plugins/mavlink_passthrough/mavlink_passthrough.h>
+
+HomeCommandChannel::HomeCommandChannel(WorkerPool& timers, Sender sender, Completion completion,
+                                       HomeChannelConfig config) :
+    _timers(timers),
+    _sender(std::move(sender)),
+    _completion(std::move(completion)),
+    _config(config)
+{}
+
+void HomeCommandChannel::submit(std::size_t pair, const HomeCommand& command) {
+    std::unique_lock<std::mutex> lock(_mutex);
+    ++_stats.submitted;
+    if (_in_flight) {
+        if (_have_pending) {
+            ++_stats.coalesced;
+        }
+        _pending = {pair, command};
+        _have_pending = true;
+        return;
+    }
+    const Attempt attempt = begin_locked({pair, command});
+    lock.unlock();
+    transmit(attempt);
+}
+
+void HomeCommandChannel::on_ack(uint8_t result, int64_t ack_ns) {
+    std::unique_lock<std::mutex> lock(_mutex);
+    if (!_in_flight) {
+        ++_stats.unmatched_acks;
+        return;
+    }
+    switch (result) {
+        case MAV_RESULT_ACCEPTED:
+            finish(lock, HomeCommandResult::Accepted, ack_ns);
+            return;
+        case MAV_RESULT_IN_PROGRESS:
+            // Still being processed; the ack timeout keeps running.
+            return;
+        case MAV_RESULT_TEMPORARILY_REJECTED: {
+            // Known to have failed, so skip the rest of the wait and retry after the backoff.
+            const uint64_t generation = ++_generation;
+            const auto delay = _timeout;
+            lock.unlock();
+            _timers.post_at(WorkerPool::Clock::now() + delay, [this, generation]() { on_timeout(generation); });
+            return;
+        }
+        default:
+            finish(lock, HomeCommandResult::Rejected, ack_ns);
+            return;
+    }
+}
+
+HomeChannelStats HomeCommandChannel::stats() const {
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _stats;
+}
+
+bool HomeCommandChannel::idle() const {
+    std::lock_guard<std::mutex> lock(_mutex);
+    return !_in_flight;
+}
+
+HomeCommandChannel::Attempt HomeCommandChannel::begin_locked(const Entry& entry) {
+    _in_flight = true;
+    _current = entry;
+    _attempt = 0;
+    _timeout = _config.ack_timeout;
+    ++_stats.sent;
+    return {_current, _attempt, _timeout, ++_generation};
+}
+
+HomeCommandChannel::Attempt HomeCommandChannel::retry_locked() {
+    ++_attempt;
+    _timeout = std::min(_timeout * 2, _config.max_ack_timeout);
+    ++_stats.sent;
+    ++_stats.retries;
+    return {_current, _attempt, _timeout, ++_generation};
+}
+
+void HomeCommandChannel::transmit(const Attempt& attempt) {
+    // Sent outside the lock: an ack arriving meanwhile finds the state already in flight.
+    _sender(attempt.entry.pair, attempt.entry.command, attempt.attempt);
+    const uint64_t generation = attempt.generation;
+    _timers.post_at(WorkerPool::Clock::now() + attempt.timeout, [this, generation]() { on_timeout(generation); });
+}
+
+void HomeCommandChannel::on_timeout(uint64_t generation) {
+    std::unique_lock<std::mutex> lock(_mutex);
+    if (!_in_flight || generation != _generation) {
+        return;
+    }
+    if (_have_pending) {
+        finish(lock, HomeCommandResult::Superseded, monotonic_ns());
+        return;
+    }
+    if (_attempt + 1 >= _config.max_attempts) {
+        finish(lock, HomeCommandResult::TimedOut, monotonic_ns());
+        return;
+    }
+    const Attempt attempt = retry_locked();
+    lock.unlock();
+    transmit(attempt);
+}
+
+void HomeCommandChannel::finish(std::unique_lock<std::mutex>& lock, HomeCommandResult result, int64_t time_ns) {
+    const Entry done = _current;
+    _in_flight = false;
+    ++_generation;
+    switch (result) {
+        case HomeCommandResult::Accepted:
+            ++_stats.accepted;
+            break;
+        case HomeCommandResult::Rejected:
+            ++_stats.rejected;
+            break;
+        case HomeCommandResult::TimedOut:
+            ++_stats.timed_out;
+            break;
+        case HomeCommandResult::Superseded:
+            ++_stats.superseded;
+            break;
+    }
+
+    bool next = false;
+    Attempt attempt{};
+    if (_have_pending) {
+        _have_pending = false;
+        attempt = begin_locked(_pending);
+        next = true;
+    }
+    lock.unlock();
+
+    if (_completion) {
+        _completion(done.pair, done.command, result, time_ns);
+    }
+    if (next) {
+        transmit(attempt);
+    }
+}
@@ -0,0 +1,118 @@
+#ifndef HOME_COMMAND_CHANNEL_H
+#define HOME_COMMAND_CHANNEL_H
+
+#include "worker_pool.h"
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+
+struct HomeCommand {
+    double latitude_deg;
+    double longitude_deg;
+    float altitude_m;
+    // Receipt time of the ship sample the command was computed from.
+    int64_t sample_time_ns;
+    // Uncertainty of the ship position extrapolated to the send time.
+    double position_sigma_m;
+    // When the follow rule started and finished for this command (monotonic).
+    int64_t compute_start_ns;
+    int64_t compute_end_ns;
+};
+
+struct HomeChannelConfig {
+    // Wait for COMMAND_ACK before the first retry; doubled after every unanswered attempt
+    // up to max_ack_timeout.
+    std::chrono::milliseconds ack_timeout{250};
+    std::chrono::milliseconds max_ack_timeout{2000};
+    // Attempts per command, the first send included.
+    int max_attempts = 5;
+};
+
+enum class HomeCommandResult { Accepted, Rejected, TimedOut, Superseded };
+
+struct HomeChannelStats {
+    uint64_t submitted = 0;
+    uint64_t sent = 0;
+    uint64_t retries = 0;
+    // Targets replaced by a newer one before they were sent.
+    uint64_t coalesced = 0;
+    uint64_t accepted = 0;
+    uint64_t rejected = 0;
+    uint64_t timed_out = 0;
+    // Sent, unanswered and then dropped for the newer pending target.
+    uint64_t superseded = 0;
+    uint64_t unmatched_acks = 0;
+};
+
+// DO_SET_HOME transport for one vehicle. At most one command is in flight; a target
+// submitted meanwhile waits in a single pending slot, and a newer target overwrites it,
+// so a burst of decisions costs one command instead of a queue of stale ones. The
+// in-flight command is resent when its ack does not arrive in time (or the vehicle
+// answers TEMPORARILY_REJECTED), with the timeout doubling per attempt. If a newer target
+// is pending at that point it is sent instead of the retry.
+//
+// COMMAND_ACK carries no sequence number; with one command in flight every DO_SET_HOME
+// ack from the vehicle belongs to it. Timers run on `timers`, which must be stopped
+// before the channel is destroyed.
+class HomeCommandChannel {
+public:
+    // Sends the command (`attempt` is 0 for the first send) and returns the monotonic
+    // send time.
+    using Sender = std::function<int64_t(std::size_t pair, const HomeCommand& command, int attempt)>;
+    // Called once for every command that was sent, when it leaves the channel.
+    using Completion = std::function<void(std::size_t pair, const HomeCommand& command, HomeCommandResult result,
+                                          int64_t time_ns)>;
+
+    HomeCommandChannel(WorkerPool& timers, Sender sender, Completion completion = nullptr,
+                       HomeChannelConfig config = {});
+
+    HomeCommandChannel(const HomeCommandChannel&) = delete;
+    HomeCommandChannel& operator=(const HomeCommandChannel&) = delete;
+
+    // `pair` is passed back through Sender and Completion untouched.
+    void submit(std::size_t pair, const HomeCommand& command);
+    // Feeds a DO_SET_HOME COMMAND_ACK result (MAV_RESULT) from this vehicle.
+    void on_ack(uint8_t result, int64_t ack_ns);
+
+    HomeChannelStats stats() const;
+    bool idle() const;
+
+private:
+    struct Entry {
+        std::size_t pair;
+        HomeCommand command;
+    };
+    struct Attempt {
+        Entry entry;
+        int attempt;
+        std::chrono::milliseconds timeout;
+        uint64_t generation;
+    };
+
+    Attempt begin_locked(const Entry& entry);
+    Attempt retry_locked();
+    void transmit(const Attempt& attempt);
+    void on_timeout(uint64_t generation);
+    // Ends the in-flight command and starts the pending one, if any. Unlocks `lock`.
+    void finish(std::unique_lock<std::mutex>& lock, HomeCommandResult result, int64_t time_ns);
+
+    WorkerPool& _timers;
+    Sender _sender;
+    Completion _completion;
+    HomeChannelConfig _config;
+
+    mutable std::mutex _mutex;
+    bool _in_flight = false;
+    Entry _current{};
+    int _attempt = 0;
+    std::chrono::milliseconds _timeout{0};
+    bool _have_pending = false;
+    Entry _pending{};
+    // Bumped on every send and completion, so timers of earlier attempts are ignored.
+    uint64_t _generation = 0;
+    HomeChannelStats _stats;
+};
+
+#endif // HOME_COMMAND_CHANNEL_H
@@ -0,0 +1,261 @@
+#include "latency_tracker.h"
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <sstream>
+
+namespace {
+
+int highest_bit(uint64_t value) {
+    return 63 - __builtin_clzll(value);
+}
+
+double to_ms(uint64_t value_us) {
+    return value_us / 1000.0;
+}
+
+} // namespace
+
+std::size_t LatencyHistogram::bucket_of(uint64_t value_us) {
+    if (value_us < 2 * SUB_BUCKETS) {
+        return static_cast<std::size_t>(value_us);
+    }
+    const int shift = highest_bit(value_us) - SUB_BUCKET_BITS;
+    if (shift > MAX_SHIFT) {
+        return BUCKETS - 1;
+    }
+    return static_cast<std::size_t>((shift + 1) * SUB_BUCKETS + static_cast<int>(value_us >> shift) - SUB_BUCKETS);
+}
+
+uint64_t LatencyHistogram::bucket_upper_us(std::size_t bucket) {
+    if (bucket < 2 * SUB_BUCKETS) {
+        return bucket;
+    }
+    const int shift = static_cast<int>(bucket / SUB_BUCKETS) - 1;
+    const uint64_t sub = bucket % SUB_BUCKETS + SUB_BUCKETS;
+    return ((sub + 1) << shift) - 1;
+}
+
+void LatencyHistogram::record(int64_t latency_ns) {
+    const uint64_t value_us = latency_ns > 0 ? static_cast<uint64_t>(latency_ns) / 1000 : 0;
+    _counts[bucket_of(value_us)].fetch_add(1, std::memory_order_relaxed);
+}
+
+void LatencyHistogram::snapshot(std::array<uint64_t, BUCKETS>& counts) const {
+    for (std::size_t i = 0; i < BUCKETS; ++i) {
+        counts[i] = _counts[i].load(std::memory_order_relaxed);
+    }
+}
+
+LatencySummary summarize(const std::array<uint64_t, LatencyHistogram::BUCKETS>& counts) {
+    LatencySummary summary{};
+    for (uint64_t count : counts) {
+        summary.count += count;
+    }
+    if (summary.count == 0) {
+        return summary;
+    }
+
+    // Each percentile is reported as the top of its bucket, so it never understates.
+    const double quantiles[3] = {0.50, 0.90, 0.99};
+    double* results[3] = {&summary.p50_ms, &summary.p90_ms, &summary.p99_ms};
+    std::size_t next = 0;
+    uint64_t seen = 0;
+    for (std::size_t bucket = 0; bucket < counts.size(); ++bucket) {
+        if (counts[bucket] == 0) {
+            continue;
+        }
+        seen += counts[bucket];
+        while (next < 3 && seen >= static_cast<uint64_t>(std::ceil(quantiles[next] * summary.count))) {
+            *results[next++] = to_ms(LatencyHistogram::bucket_upper_us(bucket));
+        }
+        summary.max_ms = to_ms(LatencyHistogram::bucket_upper_us(bucket));
+    }
+    return summary;
+}
+
+const char* latency_stage_name(LatencyStage stage) {
+    switch (stage) {
+        case LatencyStage::Queue:
+            return "queue";
+        case LatencyStage::Compute:
+            return "compute";
+        case LatencyStage::Send:
+            return "send";
+        case LatencyStage::Ack:
+            return "ack";
+        case LatencyStage::Total:
+            return "total";
+    }
+    return "unknown";
+}
+
+LatencyTracker::LatencyTracker(std::size_t pairs) {
+    _pairs.reserve(pairs);
+    for (std::size_t i = 0; i < pairs; ++i) {
+        _pairs.emplace_back(new PairLatency());
+    }
+}
+
+void LatencyTracker::record(std::size_t pair, LatencyStage stage, int64_t latency_ns) {
+    _pairs[pair]->stages[static_cast<std::size_t>(stage)].record(latency_ns);
+}
+
+void LatencyTracker::on_command_sent(std::size_t pair, int64_t sample_ns, int64_t compute_start_ns,
+                                     int64_t compute_end_ns, int64_t sent_ns) {
+    PairLatency& state = *_pairs[pair];
+    state.stages[static_cast<std::size_t>(LatencyStage::Queue)].record(compute_start_ns - sample_ns);
+    state.stages[static_cast<std::size_t>(LatencyStage::Compute)].record(compute_end_ns - compute_start_ns);
+    state.stages[static_cast<std::size_t>(LatencyStage::Send)].record(sent_ns - compute_end_ns);
+    state.commands.fetch_add(1, std::memory_order_relaxed);
+
+    // COMMAND_ACK carries no sequence number, so only the newest command is matched; an
+    // older one still in flight is counted as superseded.
+    state.pending_sample_ns.store(sample_ns, std::memory_order_relaxed);
+    if (state.pending_sent_ns.exchange(sent_ns, std::memory_order_release) != 0) {
+        state.superseded.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+void LatencyTracker::on_command_ack(std::size_t pair, int64_t ack_ns) {
+    PairLatency& state = *_pairs[pair];
+    const int64_t sent_ns = state.pending_sent_ns.exchange(0, std::memory_order_acquire);
+    if (sent_ns == 0) {
+        state.unmatched_acks.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    const int64_t sample_ns = state.pending_sample_ns.load(std::memory_order_relaxed);
+    state.stages[static_cast<std::size_t>(LatencyStage::Ack)].record(ack_ns - sent_ns);
+    state.stages[static_cast<std::size_t>(LatencyStage::Total)].record(ack_ns - sample_ns);
+    state.acks.fetch_add(1, std::memory_order_relaxed);
+}
+
+LatencyExporter::LatencyExporter(const LatencyTracker& tracker, std::vector<std::string> pair_names) :
+    _tracker(tracker),
+    _pair_names(std::move(pair_names)),
+    _previous(tracker.size() * LATENCY_STAGES)
+{
+    for (auto& counts : _previous) {
+        counts.fill(0);
+    }
+}
+
+LatencyExporter::~LatencyExporter() {
+    stop();
+}
+
+bool LatencyExporter::start(const std::string& target, std::chrono::milliseconds interval) {
+    if (target.compare(0, 5, "file:") == 0) {
+        _path = target.substr(5);
+        std::FILE* file = std::fopen(_path.c_str(), "a");
+        if (!file) {
+            return false;
+        }
+        std::fclose(file);
+    } else if (target.compare(0, 4, "udp:") == 0) {
+        const auto colon = target.rfind(':');
+        if (colon <= 4) {
+            return false;
+        }
+        sockaddr_in address{};
+        address.sin_family = AF_INET;
+        address.sin_port = htons(static_cast<uint16_t>(std::atoi(target.c_str() + colon + 1)));
+        if (::inet_pton(AF_INET, target.substr(4, colon - 4).c_str(), &address.sin_addr) != 1) {
+            return false;
+        }
+        _socket = ::socket(AF_INET, SOCK_DGRAM, 0);
+        if (_socket < 0 || ::connect(_socket, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0) {
+            return false;
+        }
+    } else {
+        return false;
+    }
+
+    _thread = std::thread([this, interval]() { run(interval); });
+    return true;
+}
+
+void LatencyExporter::stop() {
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _stopping = true;
+    }
+    _cv.notify_all();
+    if (_thread.joinable()) {
+        _thread.join();
+    }
+    if (_socket >= 0) {
+        ::close(_socket);
+        _socket = -1;
+    }
+}
+
+void LatencyExporter::run(std::chrono::milliseconds interval) {
+    std::unique_lock<std::mutex> lock(_mutex);
+    while (!_cv.wait_for(lock, interval, [this]() { return _stopping; })) {
+        lock.unlock();
+        emit(snapshot());
+        lock.lock();
+    }
+}
+
+std::string LatencyExporter::snapshot() {
+    const auto now_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                            std::chrono::steady_clock::now().time_since_epoch())
+                            .count();
+    std::ostringstream out;
+    std::array<uint64_t, LatencyHistogram::BUCKETS> counts;
+    std::array<uint64_t, LatencyHistogram::BUCKETS> window;
+    char number[160];
+
+    for (std::size_t pair = 0; pair < _tracker.size(); ++pair) {
+        out << "{\"time_ns\":" << now_ns << ",\"pair\":\""
+            << (pair < _pair_names.size() ? _pair_names[pair] : std::to_string(pair)) << "\""
+            << ",\"commands\":" << _tracker.commands(pair) << ",\"acks\":" << _tracker.acks(pair)
+            << ",\"superseded\":" << _tracker.superseded(pair)
+            << ",\"unmatched_acks\":" << _tracker.unmatched_acks(pair) << ",\"stages\":{";
+        for (std::size_t stage = 0; stage < LATENCY_STAGES; ++stage) {
+            _tracker.histogram(pair, static_cast<LatencyStage>(stage)).snapshot(counts);
+            auto& previous = _previous[pair * LATENCY_STAGES + stage];
+            for (std::size_t i = 0; i < counts.size(); ++i) {
+                window[i] = counts[i] - previous[i];
+            }
+            previous = counts;
+
+            const LatencySummary interval = summarize(window);
+            const LatencySummary total = summarize(counts);
+            std::snprintf(number, sizeof(number),
+                          "\"%s\":{\"n\":%llu,\"p50_ms\":%.3f,\"p90_ms\":%.3f,\"p99_ms\":%.3f,\"max_ms\":%.3f,"
+                          "\"total_n\":%llu,\"total_p99_ms\":%.3f}",
+                          latency_stage_name(static_cast<LatencyStage>(stage)),
+                          static_cast<unsigned long long>(interval.count), interval.p50_ms, interval.p90_ms,
+                          interval.p99_ms, interval.max_ms, static_cast<unsigned long long>(total.count),
+                          total.p99_ms);
+            out << (stage ? "," : "") << number;
+        }
+        out << "}}\n";
+    }
+    return out.str();
+}
+
+void LatencyExporter::emit(const std::string& text) {
+    if (_socket >= 0) {
+        // One datagram per pair keeps each well under the UDP size limit.
+        std::size_t begin = 0;
+        while (begin < text.size()) {
+            const std::size_t end = text.find('\n', begin);
+            ::send(_socket, text.data() + begin, end - begin + 1, 0);
+            begin = end + 1;
+        }
+        return;
+    }
+    std::FILE* file = std::fopen(_path.c_str(), "a");
+    if (file) {
+        std::fwrite(text.data(), 1, text.size(), file);
+        std::fclose(file);
+    }
+}
@@ -0,0 +1,135 @@
+#ifndef LATENCY_TRACKER_H
+#define LATENCY_TRACKER_H
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Log-linear latency histogram in the style of HdrHistogram: values are kept in
+// microseconds with 32 sub-buckets per power of two, so any recorded value is off by at
+// most ~3%, from 1 us up to ~38 hours. record() is a single relaxed fetch_add and may be
+// called from any thread; readers see a consistent-enough view for monitoring.
+class LatencyHistogram {
+public:
+    static const int SUB_BUCKET_BITS = 5;
+    static const int SUB_BUCKETS = 1 << SUB_BUCKET_BITS;
+    static const int MAX_SHIFT = 31;
+    static const std::size_t BUCKETS = (MAX_SHIFT + 2) * SUB_BUCKETS;
+
+    void record(int64_t latency_ns);
+
+    // Copies the bucket counts (not atomically as a whole, each count is exact).
+    void snapshot(std::array<uint64_t, BUCKETS>& counts) const;
+
+    static std::size_t bucket_of(uint64_t value_us);
+    // Highest value that falls into `bucket`, in microseconds.
+    static uint64_t bucket_upper_us(std::size_t bucket);
+
+private:
+    std::array<std::atomic<uint64_t>, BUCKETS> _counts{};
+};
+
+// Summary of a set of bucket counts.
+struct LatencySummary {
+    uint64_t count;
+    double p50_ms;
+    double p90_ms;
+    double p99_ms;
+    double max_ms;
+};
+
+LatencySummary summarize(const std::array<uint64_t, LatencyHistogram::BUCKETS>& counts);
+
+// Stages of one home update, all on the monotonic clock:
+//   Queue:   ship fix received -> follow rule starts
+//   Compute: estimator + geodesy
+//   Send:    decision -> DO_SET_HOME queued for sending (first attempt)
+//   Ack:     send -> COMMAND_ACK accepting it, retries included
+//   Total:   ship fix received -> COMMAND_ACK
+enum class LatencyStage { Queue, Compute, Send, Ack, Total };
+const std::size_t LATENCY_STAGES = 5;
+const char* latency_stage_name(LatencyStage stage);
+
+// Per-pair stage histograms plus DO_SET_HOME / COMMAND_ACK matching. All entry points
+// are lock-free and safe to call from MAVSDK callback and worker threads.
+class LatencyTracker {
+public:
+    explicit LatencyTracker(std::size_t pairs);
+
+    std::size_t size() const { return _pairs.size(); }
+
+    void record(std::size_t pair, LatencyStage stage, int64_t latency_ns);
+
+    // Records Queue, Compute and Send for a home command and arms the ack match.
+    void on_command_sent(std::size_t pair, int64_t sample_ns, int64_t compute_start_ns, int64_t compute_end_ns,
+                         int64_t sent_ns);
+    // Matches the ack to the last command sent for the pair. An ack with nothing pending
+    // (duplicate, or for a command we did not send) is only counted.
+    void on_command_ack(std::size_t pair, int64_t ack_ns);
+
+    const LatencyHistogram& histogram(std::size_t pair, LatencyStage stage) const {
+        return _pairs[pair]->stages[static_cast<std::size_t>(stage)];
+    }
+    uint64_t commands(std::size_t pair) const { return _pairs[pair]->commands.load(); }
+    uint64_t acks(std::size_t pair) const { return _pairs[pair]->acks.load(); }
+    // Commands replaced by a newer one before their ack arrived.
+    uint64_t superseded(std::size_t pair) const { return _pairs[pair]->superseded.load(); }
+    uint64_t unmatched_acks(std::size_t pair) const { return _pairs[pair]->unmatched_acks.load(); }
+
+private:
+    struct PairLatency {
+        std::array<LatencyHistogram, LATENCY_STAGES> stages;
+        // Send and sample time of the command waiting for its ack; 0 when none.
+        std::atomic<int64_t> pending_sent_ns{0};
+        std::atomic<int64_t> pending_sample_ns{0};
+        std::atomic<uint64_t> commands{0};
+        std::atomic<uint64_t> acks{0};
+        std::atomic<uint64_t> superseded{0};
+        std::atomic<uint64_t> unmatched_acks{0};
+    };
+
+    std::vector<std::unique_ptr<PairLatency>> _pairs;
+};
+
+// Periodically writes one JSON line per pair and stage with the p50/p90/p99/max of the
+// last interval and the running totals. `target` is "file:<path>" (lines are appended)
+// or "udp:<host>:<port>" (one datagram per snapshot, for a local dashboard).
+class LatencyExporter {
+public:
+    LatencyExporter(const LatencyTracker& tracker, std::vector<std::string> pair_names);
+    ~LatencyExporter();
+
+    LatencyExporter(const LatencyExporter&) = delete;
+    LatencyExporter& operator=(const LatencyExporter&) = delete;
+
+    bool start(const std::string& target, std::chrono::milliseconds interval);
+    void stop();
+
+    // Builds the snapshot for the interval since the previous call.
+    std::string snapshot();
+
+private:
+    void run(std::chrono::milliseconds interval);
+    void emit(const std::string& text);
+
+    const LatencyTracker& _tracker;
+    std::vector<std::string> _pair_names;
+    std::vector<std::array<uint64_t, LatencyHistogram::BUCKETS>> _previous;
+
+    std::string _path;
+    int _socket = -1;
+    std::mutex _mutex;
+    std::condition_variable _cv;
+    bool _stopping = false;
+    std::thread _thread;
+};
+
+#endif // LATENCY_TRACKER_H
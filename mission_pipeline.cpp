@@ -0,0 +1,179 @@
+#include "mission_pipeline.h"
+#include "telemetry_slot.h"
+#include <utility>
+
+MissionPipeline::MissionPipeline(MissionSync& sync, WorkerPool& pool, Completion completion,
+                                 MissionPipelineConfig config) :
+    _sync(sync),
+    _pool(pool),
+    _completion(std::move(completion)),
+    _config(config),
+    _ready(sync.have_origin() && !sync.base().empty())
+{}
+
+MissionPipeline::~MissionPipeline() {
+    stop();
+}
+
+void MissionPipeline::load(const ShipPose& origin, LoadCompletion done) {
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _ready = false;
+    }
+    _transfers.post([this, origin, done]() {
+        const bool success = _sync.load();
+        if (success) {
+            _sync.set_origin(origin);
+        }
+        const std::size_t items = _sync.base().size();
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _ready = success && items > 0;
+            start_place_locked();
+        }
+        if (done) {
+            done(success, items);
+        }
+    });
+}
+
+void MissionPipeline::submit(const ShipPose& pose) {
+    std::lock_guard<std::mutex> lock(_mutex);
+    ++_stats.submitted;
+    if (_have_pose) {
+        ++_stats.superseded;
+    }
+    _pose = pose;
+    _have_pose = true;
+    start_place_locked();
+    cancel_if_stale_locked();
+}
+
+MissionPipelineStats MissionPipeline::stats() const {
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _stats;
+}
+
+bool MissionPipeline::idle() const {
+    std::lock_guard<std::mutex> lock(_mutex);
+    return !_have_pose && !_placing && !_have_placed && !_transferring;
+}
+
+void MissionPipeline::stop() {
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        if (_transferring) {
+            _sync.link().cancel();
+        }
+    }
+    _transfers.stop();
+}
+
+void MissionPipeline::start_place_locked() {
+    if (!_ready || _placing || !_have_pose) {
+        return;
+    }
+    _placing = true;
+    _have_pose = false;
+    const ShipPose pose = _pose;
+    _pool.post([this, pose]() { place(pose); });
+}
+
+void MissionPipeline::place(ShipPose pose) {
+    // The sync's frame is only used here and placements never overlap, so this runs
+    // alongside the transfer thread's push().
+    _sync.place(pose, _placed_items);
+
+    std::lock_guard<std::mutex> lock(_mutex);
+    ++_stats.computed;
+    if (_have_placed) {
+        ++_stats.superseded;
+    }
+    std::swap(_placed, _placed_items);
+    _placed_pose = pose;
+    _have_placed = true;
+    _placing = false;
+    start_place_locked();
+    start_transfer_locked();
+    cancel_if_stale_locked();
+}
+
+void MissionPipeline::start_transfer_locked() {
+    if (_transferring || !_have_placed) {
+        return;
+    }
+    _transferring = true;
+    _have_placed = false;
+    std::swap(_transfer_items, _placed);
+    _transfer_pose = _placed_pose;
+    _transfer_start = WorkerPool::Clock::now();
+    _cancel_sent = false;
+    _timer_armed = false;
+    // Cleared under the lock, so a cancel meant for the previous transfer cannot leak
+    // into this one.
+    _sync.link().clear_cancel();
+    ++_generation;
+    _transfers.post([this]() { transfer(); });
+}
+
+void MissionPipeline::cancel_if_stale_locked() {
+    if (!_transferring || !_transfer_cancellable || _cancel_sent || !(_have_pose || _placing || _have_placed)) {
+        return;
+    }
+    const auto stale_at = _transfer_start + _config.stale_after;
+    if (WorkerPool::Clock::now() >= stale_at) {
+        _cancel_sent = true;
+        _sync.link().cancel();
+        return;
+    }
+    if (_timer_armed) {
+        return;
+    }
+    _timer_armed = true;
+    const uint64_t generation = _generation;
+    _pool.post_at(stale_at, [this, generation]() {
+        std::lock_guard<std::mutex> lock(_mutex);
+        if (generation == _generation) {
+            _timer_armed = false;
+            cancel_if_stale_locked();
+        }
+    });
+}
+
+void MissionPipeline::transfer() {
+    const int64_t start_ns = monotonic_ns();
+    const std::size_t sent_before = _sync.stats().items_sent;
+    const bool success = _sync.push(_transfer_items);
+    const std::size_t items_sent = _sync.stats().items_sent - sent_before;
+    const int64_t duration_ns = monotonic_ns() - start_ns;
+
+    MissionTransferResult result;
+    ShipPose pose;
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        result = success ? MissionTransferResult::Pushed
+                         : (_cancel_sent ? MissionTransferResult::Cancelled : MissionTransferResult::Failed);
+        switch (result) {
+            case MissionTransferResult::Pushed:
+                ++_stats.pushed;
+                break;
+            case MissionTransferResult::Failed:
+                ++_stats.failed;
+                break;
+            case MissionTransferResult::Cancelled:
+                ++_stats.cancelled;
+                break;
+        }
+        pose = _transfer_pose;
+        _transferring = false;
+        _transfer_cancellable = result != MissionTransferResult::Cancelled;
+    }
+
+    if (_completion) {
+        _completion(pose, result, items_sent, duration_ns);
+    }
+
+    std::lock_guard<std::mutex> lock(_mutex);
+    start_transfer_locked();
+    cancel_if_stale_locked();
+}
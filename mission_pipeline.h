@@ -0,0 +1,113 @@
+#ifndef MISSION_PIPELINE_H
+#define MISSION_PIPELINE_H
+
+#include "mission_sync.h"
+#include "worker_pool.h"
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+
+struct MissionPipelineConfig {
+    // A transfer still running this long after it started is cancelled once a newer pose
+    // is waiting, and the newest mission goes out instead. The transfer that replaces a
+    // cancelled one always runs to the end, so a link slower than the pose rate still
+    // lands every other mission instead of none.
+    std::chrono::milliseconds stale_after{1000};
+};
+
+enum class MissionTransferResult { Pushed, Failed, Cancelled };
+
+struct MissionPipelineStats {
+    uint64_t submitted = 0;
+    uint64_t computed = 0;
+    // Poses replaced by a newer one before their mission was computed or sent.
+    uint64_t superseded = 0;
+    uint64_t pushed = 0;
+    uint64_t failed = 0;
+    // Transfers cut short for a newer pose.
+    uint64_t cancelled = 0;
+};
+
+// Keeps the vehicle mission following the ship without blocking the caller. submit() only
+// records the pose; the mission for it is placed (MissionSync::place) on `pool` while the
+// previous one is still being transferred, and the transfers themselves run one at a time
+// on the pipeline's own thread, since MissionLink calls block for the whole exchange.
+// Each stage holds a single slot that a newer pose overwrites, so a burst of poses costs
+// one placement and one transfer, never a queue of stale missions. A transfer that has
+// gone stale (see MissionPipelineConfig) is cancelled through MissionLink::cancel().
+//
+// The MissionSync must not be used elsewhere while the pipeline runs. `pool` carries the
+// placement work and the stale-transfer timers and must be stopped before the pipeline is
+// destroyed; it must not be the pool passed to MissionFrame for parallel batches.
+class MissionPipeline {
+public:
+    // Called on the transfer thread after every transfer.
+    using Completion = std::function<void(const ShipPose& pose, MissionTransferResult result, std::size_t items_sent,
+                                          int64_t duration_ns)>;
+    using LoadCompletion = std::function<void(bool success, std::size_t items)>;
+
+    MissionPipeline(MissionSync& sync, WorkerPool& pool, Completion completion = nullptr,
+                    MissionPipelineConfig config = {});
+    ~MissionPipeline();
+
+    MissionPipeline(const MissionPipeline&) = delete;
+    MissionPipeline& operator=(const MissionPipeline&) = delete;
+
+    // Downloads the vehicle mission on the transfer thread and anchors it at `origin`.
+    // Poses submitted meanwhile wait for it. Without load(), the sync's current base and
+    // origin are used. An empty mission leaves the pipeline idle. Call before the first
+    // submit().
+    void load(const ShipPose& origin, LoadCompletion done = nullptr);
+
+    void submit(const ShipPose& pose);
+
+    MissionPipelineStats stats() const;
+    bool idle() const;
+
+    // Cancels a running transfer and joins the transfer thread; queued work is dropped.
+    // Also done by the destructor.
+    void stop();
+
+private:
+    void start_place_locked();
+    void start_transfer_locked();
+    void cancel_if_stale_locked();
+    void place(ShipPose pose);
+    void transfer();
+
+    MissionSync& _sync;
+    WorkerPool& _pool;
+    Completion _completion;
+    MissionPipelineConfig _config;
+
+    mutable std::mutex _mutex;
+    bool _ready;
+    // Newest pose not yet placed.
+    bool _have_pose = false;
+    ShipPose _pose{};
+    bool _placing = false;
+    // Placement buffer; only the running place() touches it.
+    MissionItems _placed_items;
+    // Newest placed mission not yet sent.
+    bool _have_placed = false;
+    ShipPose _placed_pose{};
+    MissionItems _placed;
+    // Transfer in flight; its items are only touched by the transfer thread.
+    bool _transferring = false;
+    ShipPose _transfer_pose{};
+    MissionItems _transfer_items;
+    WorkerPool::Clock::time_point _transfer_start{};
+    bool _transfer_cancellable = true;
+    bool _cancel_sent = false;
+    bool _timer_armed = false;
+    // Bumped per transfer, so a stale-check timer only acts on the transfer it was set for.
+    uint64_t _generation = 0;
+    MissionPipelineStats _stats;
+
+    // Declared last: its thread must stop before the members above go away.
+    WorkerPool _transfers{1};
+};
+
+#endif // MISSION_PIPELINE_H
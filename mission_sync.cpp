@@ -0,0 +1,418 @@
+#include "mission_sync.h"
+#include "coordinates.h"
+#include "geodesy.h"
+#include <algorithm>
+#include <cmath>
+#include <condition_variable>
+#include <future>
+#include <memory>
+#include <mutex>
+
+using namespace mavsdk;
+
+namespace {
+
+bool is_global_frame(uint32_t frame) {
+    switch (frame) {
+        case MAV_FRAME_GLOBAL:
+        case MAV_FRAME_GLOBAL_RELATIVE_ALT:
+        case MAV_FRAME_GLOBAL_INT:
+        case MAV_FRAME_GLOBAL_RELATIVE_ALT_INT:
+        case MAV_FRAME_GLOBAL_TERRAIN_ALT:
+        case MAV_FRAME_GLOBAL_TERRAIN_ALT_INT:
+            return true;
+        default:
+            return false;
+    }
+}
+
+bool has_position(const MissionRaw::MissionItem& item) {
+    return is_global_frame(item.frame) && (item.x != 0 || item.y != 0);
+}
+
+bool same_item(const MissionRaw::MissionItem& a, const MissionRaw::MissionItem& b) {
+    return a.seq == b.seq && a.frame == b.frame && a.command == b.command && a.current == b.current &&
+           a.autocontinue == b.autocontinue && a.param1 == b.param1 && a.param2 == b.param2 &&
+           a.param3 == b.param3 && a.param4 == b.param4 && a.x == b.x && a.y == b.y && a.z == b.z &&
+           a.mission_type == b.mission_type;
+}
+
+// lround() without the libm call, so the transform loop stays inline.
+int32_t round_to_int32(double value) {
+    return static_cast<int32_t>(value < 0 ? value - 0.5 : value + 0.5);
+}
+
+// State shared with the passthrough callbacks of one partial write; held by shared_ptr so a
+// late callback never touches a finished stack frame.
+struct PartialWriteState {
+    std::mutex mutex;
+    std::condition_variable cv;
+    int requested_seq = -1;
+    bool acked = false;
+    uint8_t ack_type = 0;
+};
+
+} // namespace
+
+MavsdkMissionLink::MavsdkMissionLink(MissionRaw& mission_raw, MavlinkPassthrough& passthrough) :
+    _mission_raw(mission_raw),
+    _passthrough(passthrough)
+{}
+
+bool MavsdkMissionLink::download(MissionItems& items) {
+    auto result = _mission_raw.download_mission();
+    if (result.first != MissionRaw::Result::Success) {
+        return false;
+    }
+    items = std::move(result.second);
+    return true;
+}
+
+bool MavsdkMissionLink::upload(const MissionItems& items) {
+    // Async so that cancel_mission_upload() from another thread can end the wait.
+    auto result = std::make_shared<std::promise<MissionRaw::Result>>();
+    auto done = result->get_future();
+    _mission_raw.upload_mission_async(items, [result](MissionRaw::Result value) { result->set_value(value); });
+    // A cancel that arrived after MissionSync's last check but before the upload existed
+    // found nothing to stop; repeat it now that the upload is running.
+    if (cancelled()) {
+        _mission_raw.cancel_mission_upload();
+    }
+    return done.get() == MissionRaw::Result::Success;
+}
+
+void MavsdkMissionLink::on_cancel() {
+    _mission_raw.cancel_mission_upload();
+}
+
+bool MavsdkMissionLink::write_partial(const MissionItems& items, uint16_t start, uint16_t end) {
+    const uint8_t target_sysid = _passthrough.get_target_sysid();
+    const uint8_t target_compid = _passthrough.get_target_compid();
+    auto state = std::make_shared<PartialWriteState>();
+
+    auto on_request = [state](uint16_t seq, uint8_t mission_type) {
+        if (mission_type != MAV_MISSION_TYPE_MISSION) {
+            return;
+        }
+        std::lock_guard<std::mutex> lock(state->mutex);
+        state->requested_seq = seq;
+        state->cv.notify_one();
+    };
+    auto request_int_handle = _passthrough.subscribe_message(
+        MAVLINK_MSG_ID_MISSION_REQUEST_INT, [on_request](const mavlink_message_t& message) {
+            mavlink_mission_request_int_t request;
+            mavlink_msg_mission_request_int_decode(&message, &request);
+            on_request(request.seq, request.mission_type);
+        });
+    auto request_handle = _passthrough.subscribe_message(
+        MAVLINK_MSG_ID_MISSION_REQUEST, [on_request](const mavlink_message_t& message) {
+            mavlink_mission_request_t request;
+            mavlink_msg_mission_request_decode(&message, &request);
+            on_request(request.seq, request.mission_type);
+        });
+    auto ack_handle = _passthrough.subscribe_message(
+        MAVLINK_MSG_ID_MISSION_ACK, [state](const mavlink_message_t& message) {
+            mavlink_mission_ack_t ack;
+            mavlink_msg_mission_ack_decode(&message, &ack);
+            if (ack.mission_type != MAV_MISSION_TYPE_MISSION) {
+                return;
+            }
+            std::lock_guard<std::mutex> lock(state->mutex);
+            state->acked = true;
+            state->ack_type = ack.type;
+            state->cv.notify_one();
+        });
+
+    auto send_partial_list = [&]() {
+        _passthrough.queue_message([=](MavlinkPassthrough::MavlinkAddress address, uint8_t channel) {
+            mavlink_message_t message;
+            mavlink_msg_mission_write_partial_list_pack_chan(
+                address.system_id, address.component_id, channel, &message, target_sysid, target_compid,
+                static_cast<int16_t>(start), static_cast<int16_t>(end), MAV_MISSION_TYPE_MISSION);
+            return message;
+        });
+    };
+    auto send_item = [&](uint16_t seq) {
+        const MissionRaw::MissionItem item = items[seq];
+        _passthrough.queue_message([=](MavlinkPassthrough::MavlinkAddress address, uint8_t channel) {
+            mavlink_message_t message;
+            mavlink_msg_mission_item_int_pack_chan(
+                address.system_id, address.component_id, channel, &message, target_sysid, target_compid,
+                seq, static_cast<uint8_t>(item.frame), static_cast<uint16_t>(item.command),
+                static_cast<uint8_t>(item.current), static_cast<uint8_t>(item.autocontinue),
+                item.param1, item.param2, item.param3, item.param4, item.x, item.y, item.z,
+                MAV_MISSION_TYPE_MISSION);
+            return message;
+        });
+    };
+
+    // The vehicle drives the transfer: it requests each item and finishes with MISSION_ACK.
+    // On a timeout the last message is sent again.
+    bool success = false;
+    int last_sent = -1;
+    int attempts = 0;
+    send_partial_list();
+    while (true) {
+        std::unique_lock<std::mutex> lock(state->mutex);
+        const bool woke = state->cv.wait_for(lock, item_timeout, [&state]() {
+            return state->acked || state->requested_seq >= 0;
+        });
+        if (!woke) {
+            lock.unlock();
+            if (++attempts > retries) {
+                break;
+            }
+            if (last_sent < 0) {
+                send_partial_list();
+            } else {
+                send_item(static_cast<uint16_t>(last_sent));
+            }
+            continue;
+        }
+        if (state->acked) {
+            success = state->ack_type == MAV_MISSION_ACCEPTED;
+            break;
+        }
+        const int seq = state->requested_seq;
+        state->requested_seq = -1;
+        lock.unlock();
+
+        if (seq < start || seq > end || seq >= static_cast<int>(items.size())) {
+            break;
+        }
+        attempts = 0;
+        last_sent = seq;
+        send_item(static_cast<uint16_t>(seq));
+    }
+
+    _passthrough.unsubscribe_message(MAVLINK_MSG_ID_MISSION_REQUEST_INT, request_int_handle);
+    _passthrough.unsubscribe_message(MAVLINK_MSG_ID_MISSION_REQUEST, request_handle);
+    _passthrough.unsubscribe_message(MAVLINK_MSG_ID_MISSION_ACK, ack_handle);
+    return success;
+}
+
+void translate_mission(const MissionItems& base, double bearing, double distance, MissionItems& out) {
+    // SoA scratch for the batch API, reused across calls.
+    thread_local std::vector<double> lat;
+    thread_local std::vector<double> lon;
+    lat.clear();
+    lon.clear();
+
+    out = base;
+    for (const auto& item : base) {
+        if (has_position(item)) {
+            lat.push_back(item.x / 1e7);
+            lon.push_back(item.y / 1e7);
+        }
+    }
+
+    translate_coordinates_batch({lat.data(), lon.data(), lat.size()}, bearing, distance,
+                                {lat.data(), lon.data(), lat.size()});
+
+    std::size_t next = 0;
+    for (auto& item : out) {
+        if (has_position(item)) {
+            item.x = static_cast<int32_t>(std::lround(lat[next] * 1e7));
+            item.y = static_cast<int32_t>(std::lround(lon[next] * 1e7));
+            ++next;
+        }
+    }
+}
+
+void MissionFrame::capture(const MissionItems& base, const ShipPose& origin) {
+    _base = base;
+    _index.clear();
+    _forward_mm.clear();
+    _right_mm.clear();
+
+    const Geodesy<GeodesyTier::LocalTangentPlane, double> frame(origin.latitude_deg, origin.longitude_deg);
+    const double heading = origin.heading_deg * M_PI / 180.0;
+    const double sin_heading = std::sin(heading);
+    const double cos_heading = std::cos(heading);
+    for (std::size_t i = 0; i < base.size(); ++i) {
+        if (!has_position(base[i])) {
+            continue;
+        }
+        double east;
+        double north;
+        frame.to_enu(base[i].x / 1e7, base[i].y / 1e7, east, north);
+        _index.push_back(static_cast<uint32_t>(i));
+        _forward_mm.push_back(static_cast<int32_t>(std::lround((north * cos_heading + east * sin_heading) * 1000)));
+        _right_mm.push_back(static_cast<int32_t>(std::lround((east * cos_heading - north * sin_heading) * 1000)));
+    }
+}
+
+void MissionFrame::transform(const ShipPose& pose, int32_t* x, int32_t* y, WorkerPool* pool) const {
+    const Geodesy<GeodesyTier::LocalTangentPlane, double> frame(pose.latitude_deg, pose.longitude_deg);
+    const double heading = pose.heading_deg * M_PI / 180.0;
+    // Millimetres to metres folded into the rotation.
+    const double sin_heading = std::sin(heading) / 1000;
+    const double cos_heading = std::cos(heading) / 1000;
+    const int32_t* forward = _forward_mm.data();
+    const int32_t* right = _right_mm.data();
+
+    auto run = [&frame, sin_heading, cos_heading, forward, right, x, y](std::size_t begin, std::size_t end) {
+        for (std::size_t i = begin; i < end; ++i) {
+            const double north = forward[i] * cos_heading - right[i] * sin_heading;
+            const double east = forward[i] * sin_heading + right[i] * cos_heading;
+            double latitude_deg;
+            double longitude_deg;
+            frame.from_enu(east, north, latitude_deg, longitude_deg);
+            x[i] = round_to_int32(latitude_deg * 1e7);
+            y[i] = round_to_int32(longitude_deg * 1e7);
+        }
+    };
+
+    const std::size_t n = size();
+    if (!pool || pool->size() < 2 || n < PARALLEL_MIN_ITEMS) {
+        run(0, n);
+        return;
+    }
+
+    // One chunk per worker; this thread takes the last one and then waits for the rest.
+    const std::size_t chunks = pool->size();
+    const std::size_t chunk = (n + chunks - 1) / chunks;
+    std::mutex mutex;
+    std::condition_variable done;
+    std::size_t remaining = 0;
+    for (std::size_t begin = 0; begin + chunk < n; begin += chunk) {
+        ++remaining;
+    }
+    // `remaining` belongs to the workers once they are posted.
+    const std::size_t posted = remaining;
+    for (std::size_t begin = 0; begin + chunk < n; begin += chunk) {
+        pool->post([&, begin]() {
+            run(begin, begin + chunk);
+            std::lock_guard<std::mutex> lock(mutex);
+            if (--remaining == 0) {
+                done.notify_one();
+            }
+        });
+    }
+    run(posted * chunk, n);
+    std::unique_lock<std::mutex> lock(mutex);
+    done.wait(lock, [&remaining]() { return remaining == 0; });
+}
+
+void MissionFrame::apply(const ShipPose& pose, MissionItems& out, WorkerPool* pool) {
+    _x.resize(size());
+    _y.resize(size());
+    transform(pose, _x.data(), _y.data(), pool);
+    out = _base;
+    for (std::size_t i = 0; i < _index.size(); ++i) {
+        out[_index[i]].x = _x[i];
+        out[_index[i]].y = _y[i];
+    }
+}
+
+MissionSync::MissionSync(MissionLink& link) :
+    _link(link)
+{}
+
+bool MissionSync::load() {
+    MissionItems items;
+    if (!_link.download(items)) {
+        _in_sync = false;
+        return false;
+    }
+    _base = items;
+    _acked = std::move(items);
+    _in_sync = true;
+    if (_have_origin) {
+        _frame.capture(_base, _origin);
+    }
+    return true;
+}
+
+void MissionSync::set_base(const MissionItems& base) {
+    _base = base;
+    if (_have_origin) {
+        _frame.capture(_base, _origin);
+    }
+}
+
+void MissionSync::set_origin(const ShipPose& origin) {
+    _origin = origin;
+    _have_origin = true;
+    _frame.capture(_base, _origin);
+}
+
+bool MissionSync::update(double bearing, double distance) {
+    translate_mission(_base, bearing, distance, _scratch);
+    return push(_scratch);
+}
+
+bool MissionSync::update(const ShipPose& pose, WorkerPool* pool) {
+    return place(pose, _scratch, pool) && push(_scratch);
+}
+
+bool MissionSync::place(const ShipPose& pose, MissionItems& out, WorkerPool* pool) {
+    if (!_have_origin) {
+        return false;
+    }
+    _frame.apply(pose, out, pool);
+    return true;
+}
+
+bool MissionSync::push(const MissionItems& target) {
+    if (!_in_sync || _partial_unsupported || target.size() != _acked.size()) {
+        return full_upload(target);
+    }
+    for (std::size_t i = 0; i < target.size(); ++i) {
+        if (target[i].seq != i) {
+            return full_upload(target);
+        }
+    }
+
+    std::size_t i = 0;
+    while (i < target.size()) {
+        if (_link.cancelled()) {
+            return false;
+        }
+        if (same_item(target[i], _acked[i])) {
+            ++i;
+            continue;
+        }
+
+        // Grow the run while the next change is at most merge_gap items away.
+        const std::size_t start = i;
+        std::size_t end = i;
+        for (std::size_t j = i + 1; j < target.size() && j - end <= merge_gap + 1; ++j) {
+            if (!same_item(target[j], _acked[j])) {
+                end = j;
+            }
+        }
+
+        if (!_link.write_partial(target, static_cast<uint16_t>(start), static_cast<uint16_t>(end))) {
+            if (_link.cancelled()) {
+                // The run may be half written; only a full upload restores a known state.
+                _in_sync = false;
+                return false;
+            }
+            _partial_unsupported = true;
+            return full_upload(target);
+        }
+        for (std::size_t k = start; k <= end; ++k) {
+            _acked[k] = target[k];
+        }
+        _stats.items_sent += end - start + 1;
+        ++_stats.partial_writes;
+        i = end + 1;
+    }
+    return true;
+}
+
+bool MissionSync::full_upload(const MissionItems& target) {
+    if (_link.cancelled()) {
+        return false;
+    }
+    if (!_link.upload(target)) {
+        _in_sync = false;
+        return false;
+    }
+    _acked = target;
+    _in_sync = true;
+    _stats.items_sent += target.size();
+    ++_stats.full_uploads;
+    return true;
+}
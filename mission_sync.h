@@ -0,0 +1,183 @@
+#ifndef MISSION_SYNC_H
+#define MISSION_SYNC_H
+
+#include "worker_pool.h"
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <vector>
+#include <mavsdk/plugins/mission_raw/mission_raw.h>
+#include <mavsdk/plugins/mavlink_passthrough/mavlink_passthrough.h>
+
+using MissionItems = std::vector<mavsdk::MissionRaw::MissionItem>;
+
+// Mission transfer primitives used by MissionSync. Kept abstract so the sync logic
+// can run against a mock vehicle as well as a real link.
+class MissionLink {
+public:
+    virtual ~MissionLink() = default;
+
+    virtual bool download(MissionItems& items) = 0;
+    virtual bool upload(const MissionItems& items) = 0;
+    // Overwrites items [start, end] (inclusive) of the mission already on the vehicle.
+    virtual bool write_partial(const MissionItems& items, uint16_t start, uint16_t end) = 0;
+
+    // Asks a transfer running on another thread to stop early; it then fails. Full uploads
+    // are aborted (the vehicle keeps its previous mission); partial writes are never cut
+    // off mid-run, MissionSync stops between them. Stays set until clear_cancel().
+    // Sequentially consistent, so a link that starts a transfer and then checks cancelled()
+    // either sees the flag or is seen by on_cancel().
+    void cancel() {
+        _cancelled.store(true);
+        on_cancel();
+    }
+    void clear_cancel() { _cancelled.store(false); }
+    bool cancelled() const { return _cancelled.load(); }
+
+protected:
+    virtual void on_cancel() {}
+
+private:
+    std::atomic<bool> _cancelled{false};
+};
+
+// MissionRaw for full transfers, MISSION_WRITE_PARTIAL_LIST over MAVLink passthrough for partial ones.
+class MavsdkMissionLink : public MissionLink {
+public:
+    MavsdkMissionLink(mavsdk::MissionRaw& mission_raw, mavsdk::MavlinkPassthrough& passthrough);
+
+    bool download(MissionItems& items) override;
+    bool upload(const MissionItems& items) override;
+    bool write_partial(const MissionItems& items, uint16_t start, uint16_t end) override;
+
+    // Time to wait for each MISSION_REQUEST_INT / MISSION_ACK during a partial write.
+    std::chrono::milliseconds item_timeout{250};
+    int retries = 3;
+
+protected:
+    void on_cancel() override;
+
+private:
+    mavsdk::MissionRaw& _mission_raw;
+    mavsdk::MavlinkPassthrough& _passthrough;
+};
+
+// Translates the global-frame items of `base` by `bearing` (degrees) and `distance` (km)
+// into `out`. Items without a global position (RTL, speed changes, ...) are copied as is.
+void translate_mission(const MissionItems& base, double bearing, double distance, MissionItems& out);
+
+// Where the ship is and which way it points.
+struct ShipPose {
+    double latitude_deg;
+    double longitude_deg;
+    // Heading (yaw) in degrees clockwise from true north.
+    double heading_deg;
+};
+
+// A mission kept relative to the ship. capture() stores every positional item once as a
+// fixed-point offset (millimetres, forward/starboard) in the body frame of the ship pose
+// the mission was planned around; transform() then places the mission around any later
+// pose with one rotation and a local-tangent-plane translation per item: sin/cos of the
+// heading are taken once per call and the items need no trig. The mission therefore
+// turns with the ship as well as following it. Offsets are exact to ~2e-5 of their
+// length within 20 km of the ship (see GeodesyTier::LocalTangentPlane).
+class MissionFrame {
+public:
+    // Batches of at least this many items are split across the pool, if one is given.
+    static const std::size_t PARALLEL_MIN_ITEMS = 16384;
+
+    void capture(const MissionItems& base, const ShipPose& origin);
+
+    const MissionItems& base() const { return _base; }
+    // Number of positional items.
+    std::size_t size() const { return _forward_mm.size(); }
+
+    // Writes the positional items for the ship at `pose` to x/y (degrees * 1e7), in
+    // mission order. With a pool, large batches run in parallel; the call waits for them,
+    // so it must not run on a task of that pool.
+    void transform(const ShipPose& pose, int32_t* x, int32_t* y, WorkerPool* pool = nullptr) const;
+
+    // The whole mission for the ship at `pose`: base() with the positional items moved.
+    void apply(const ShipPose& pose, MissionItems& out, WorkerPool* pool = nullptr);
+
+private:
+    MissionItems _base;
+    // Mission index of each positional item, and its body-frame offset.
+    std::vector<uint32_t> _index;
+    std::vector<int32_t> _forward_mm;
+    std::vector<int32_t> _right_mm;
+    // Output of transform() for apply(), reused across calls.
+    std::vector<int32_t> _x;
+    std::vector<int32_t> _y;
+};
+
+// Local copy of the vehicle mission, kept as the source of truth so the vehicle does not
+// have to be re-downloaded every cycle. push() only sends the items that differ from
+// what the vehicle last acknowledged.
+class MissionSync {
+public:
+    struct Stats {
+        std::size_t items_sent = 0;
+        std::size_t partial_writes = 0;
+        std::size_t full_uploads = 0;
+    };
+
+    explicit MissionSync(MissionLink& link);
+
+    // Downloads the mission once; it becomes both the base mission and the acknowledged state.
+    bool load();
+
+    // Replaces the base mission without touching the vehicle, e.g. for a mission loaded from disk.
+    void set_base(const MissionItems& base);
+
+    const MissionItems& base() const { return _base; }
+    const MissionItems& acknowledged() const { return _acked; }
+
+    // Translates the base mission by the given offset and pushes the result.
+    bool update(double bearing, double distance);
+
+    // Ship-relative following: the base mission is held against `origin`, the pose it
+    // was planned around (kept across load() and set_base()), and update(pose) places it
+    // around the current pose, turning it with the ship. Fails without an origin.
+    void set_origin(const ShipPose& origin);
+    bool update(const ShipPose& pose, WorkerPool* pool = nullptr);
+    // The placement half of update(pose): writes the mission for `pose` to `out` without
+    // pushing it. Does not touch the acknowledged state, so it may run while push() is
+    // busy on another thread, but not concurrently with itself.
+    bool place(const ShipPose& pose, MissionItems& out, WorkerPool* pool = nullptr);
+    bool have_origin() const { return _have_origin; }
+
+    // Sends the items of `target` that differ from the acknowledged mission, one partial
+    // write per run of changed items. Falls back to a full upload when the mission length
+    // or sequence numbers no longer match, or when a partial write is rejected. A cancel
+    // on the link stops it between partial writes; the items written so far stay acked.
+    // The first rejected or timed-out partial write (PX4 ignores them) turns partial
+    // writes off for good, so later pushes upload at once instead of waiting out retries.
+    bool push(const MissionItems& target);
+    bool partial_writes_supported() const { return !_partial_unsupported; }
+
+    // Forces the next push() to do a full upload.
+    void invalidate() { _in_sync = false; }
+
+    const Stats& stats() const { return _stats; }
+    MissionLink& link() { return _link; }
+
+    // Runs separated by at most this many unchanged items are merged into one partial write.
+    std::size_t merge_gap = 2;
+
+private:
+    bool full_upload(const MissionItems& target);
+
+    MissionLink& _link;
+    MissionItems _base;
+    MissionItems _acked;
+    MissionItems _scratch;
+    MissionFrame _frame;
+    bool _have_origin = false;
+    ShipPose _origin{};
+    bool _in_sync = false;
+    bool _partial_unsupported = false;
+    Stats _stats;
+};
+
+#endif // MISSION_SYNC_H
@@ -0,0 +1,209 @@
+#include "rate_controller.h"
+#include "telemetry_slot.h"
+#include <algorithm>
+#include <cmath>
+#include <utility>
+
+const char* rate_reason_name(RateReason reason) {
+    switch (reason) {
+        case RateReason::Speed:
+            return "speed";
+        case RateReason::Threshold:
+            return "threshold";
+        case RateReason::Minimum:
+            return "minimum";
+        case RateReason::Link:
+            return "link";
+    }
+    return "unknown";
+}
+
+RateController::RateController(double initial_hz, RateControllerConfig config) :
+    _config(config),
+    _rate_hz(initial_hz)
+{}
+
+RateDecision RateController::update(const RateInputs& inputs, int64_t now_ns) {
+    const double speed = std::max(0.0, inputs.speed_m_s);
+    const double speed_hz = speed / _config.max_travel_per_sample_m;
+    // Below one sample's travel the margin no longer says anything; the speed term covers it.
+    const double margin = std::max(std::fabs(inputs.margin_m), _config.max_travel_per_sample_m);
+    const double margin_hz = _config.samples_per_margin * speed / margin;
+
+    RateDecision decision{};
+    decision.rate_hz = std::max(speed_hz, margin_hz);
+    decision.reason = margin_hz > speed_hz ? RateReason::Threshold : RateReason::Speed;
+    if (decision.rate_hz <= _config.min_hz) {
+        decision.rate_hz = _config.min_hz;
+        decision.reason = RateReason::Minimum;
+    }
+    decision.rate_hz = std::min(decision.rate_hz, _config.max_hz);
+
+    // The link measurement includes this vehicle's own stream at the current rate; what is
+    // left of the budget after everything else is what it may use, but never less than the
+    // floor, so a busy link does not make tracking worse than a fixed rate would.
+    if (_config.link_budget_bytes_s > 0 && inputs.link_bytes_s >= 0) {
+        const double others = std::max(0.0, inputs.link_bytes_s - _rate_hz * _config.bytes_per_hz);
+        const double link_hz = (_config.max_link_share * _config.link_budget_bytes_s - others) / _config.bytes_per_hz;
+        const double capped = std::max(link_hz, std::min(_config.link_floor_hz, decision.rate_hz));
+        if (capped < decision.rate_hz) {
+            decision.rate_hz = std::max(_config.min_hz, capped);
+            decision.reason = RateReason::Link;
+        }
+    }
+
+    if (decision.rate_hz > _rate_hz * (1 + _config.change_ratio)) {
+        decision.change = true;
+        _lower_since_ns = 0;
+    } else if (decision.rate_hz < _rate_hz * (1 - _config.change_ratio)) {
+        if (_lower_since_ns == 0) {
+            _lower_since_ns = now_ns;
+        }
+        const int64_t hold_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(_config.lower_after).count();
+        // An overloaded link is relieved at once.
+        decision.change = decision.reason == RateReason::Link || now_ns - _lower_since_ns >= hold_ns;
+    } else {
+        _lower_since_ns = 0;
+    }
+    return decision;
+}
+
+void RateController::applied(double rate_hz) {
+    _rate_hz = rate_hz;
+    _lower_since_ns = 0;
+}
+
+TelemetryRateLoop::TelemetryRateLoop(uint8_t sysid, double initial_hz, RateControllerConfig config,
+                                     const LinkMeter& meter, std::vector<uint8_t> link,
+                                     const LatencyTracker* latency,
+                                     std::vector<std::size_t> pairs, InputSource inputs, RateSetter set_rate,
+                                     ChangeLog change_log, EffectLog effect_log,
+                                     std::chrono::milliseconds effect_window) :
+    _sysid(sysid),
+    _controller(initial_hz, config),
+    _meter(meter),
+    _link(std::move(link)),
+    _latency(latency),
+    _pairs(std::move(pairs)),
+    _inputs(std::move(inputs)),
+    _set_rate(std::move(set_rate)),
+    _change_log(std::move(change_log)),
+    _effect_log(std::move(effect_log)),
+    _effect_window(effect_window),
+    _rate_hz(initial_hz)
+{}
+
+void TelemetryRateLoop::start(WorkerPool& timers, std::chrono::milliseconds period) {
+    _period = period;
+    const auto first = WorkerPool::Clock::now() + period;
+    timers.post_at(first, [this, &timers, first]() { tick(timers, first); });
+}
+
+void TelemetryRateLoop::mark(int64_t now_ns, Mark& out) const {
+    out.time_ns = now_ns;
+    out.bytes = _meter.bytes(_sysid);
+    out.positions = _meter.positions(_sysid);
+    out.latency.fill(0);
+    if (!_latency) {
+        return;
+    }
+    Counts counts;
+    for (const std::size_t pair : _pairs) {
+        _latency->histogram(pair, LatencyStage::Total).snapshot(counts);
+        for (std::size_t i = 0; i < counts.size(); ++i) {
+            out.latency[i] += counts[i];
+        }
+    }
+}
+
+namespace {
+
+void latency_between(const std::array<uint64_t, LatencyHistogram::BUCKETS>& from,
+                     const std::array<uint64_t, LatencyHistogram::BUCKETS>& to, LatencySummary& latency) {
+    std::array<uint64_t, LatencyHistogram::BUCKETS> counts;
+    for (std::size_t i = 0; i < counts.size(); ++i) {
+        counts[i] = to[i] - from[i];
+    }
+    latency = summarize(counts);
+}
+
+double per_second(uint64_t count, int64_t duration_ns) {
+    return duration_ns > 0 ? count * 1e9 / duration_ns : 0;
+}
+
+double mean_interval_ms(uint64_t samples, int64_t duration_ns) {
+    return samples > 0 ? duration_ns / 1e6 / samples : 0;
+}
+
+} // namespace
+
+void TelemetryRateLoop::report_effect(const Mark& now) {
+    _effect_pending = false;
+    if (!_effect_log) {
+        return;
+    }
+    const int64_t before_ns = _current_start.time_ns - _previous_start.time_ns;
+    const int64_t after_ns = now.time_ns - _current_start.time_ns;
+
+    RateEffect effect{};
+    effect.sysid = _sysid;
+    effect.from_hz = _previous_hz;
+    effect.to_hz = _controller.rate_hz();
+    effect.bytes_s_before = per_second(_current_start.bytes - _previous_start.bytes, before_ns);
+    effect.bytes_s_after = per_second(now.bytes - _current_start.bytes, after_ns);
+    effect.interval_ms_before = mean_interval_ms(_current_start.positions - _previous_start.positions, before_ns);
+    effect.interval_ms_after = mean_interval_ms(now.positions - _current_start.positions, after_ns);
+    latency_between(_previous_start.latency, _current_start.latency, effect.latency_before);
+    latency_between(_current_start.latency, now.latency, effect.latency_after);
+    _effect_log(effect);
+}
+
+void TelemetryRateLoop::tick(WorkerPool& timers, WorkerPool::Clock::time_point when) {
+    const int64_t now_ns = monotonic_ns();
+
+    const uint64_t link_bytes = _meter.bytes(_link);
+    if (_last_tick_ns == 0) {
+        mark(now_ns, _current_start);
+    } else if (now_ns > _last_tick_ns) {
+        const double bytes_s = per_second(link_bytes - _last_link_bytes, now_ns - _last_tick_ns);
+        _link_bytes_s = _link_bytes_s < 0 ? bytes_s : (_link_bytes_s + bytes_s) / 2;
+    }
+    _last_tick_ns = now_ns;
+    _last_link_bytes = link_bytes;
+
+    const int64_t window_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(_effect_window).count();
+    if (_effect_pending && now_ns - _current_start.time_ns >= window_ns) {
+        Mark now;
+        mark(now_ns, now);
+        report_effect(now);
+    }
+
+    RateInputs inputs{0, 0, _link_bytes_s};
+    if (_inputs(inputs)) {
+        inputs.link_bytes_s = _link_bytes_s;
+        const RateDecision decision = _controller.update(inputs, now_ns);
+        if (decision.change && _set_rate(decision.rate_hz)) {
+            Mark now;
+            mark(now_ns, now);
+            // A change before the last one's window closed reports it over the shorter time.
+            if (_effect_pending) {
+                report_effect(now);
+            }
+            const double from_hz = _controller.rate_hz();
+            _controller.applied(decision.rate_hz);
+            _rate_hz.store(decision.rate_hz, std::memory_order_relaxed);
+            _changes.fetch_add(1, std::memory_order_relaxed);
+            _previous_start = _current_start;
+            _current_start = now;
+            _previous_hz = from_hz;
+            _effect_pending = true;
+            if (_change_log) {
+                _change_log({_sysid, now_ns, from_hz, decision.rate_hz, decision.reason, inputs});
+            }
+        }
+    }
+
+    // Scheduled from the previous deadline so ticks do not drift with the work they do.
+    const auto next = std::max(when + _period, WorkerPool::Clock::now());
+    timers.post_at(next, [this, &timers, next]() { tick(timers, next); });
+}
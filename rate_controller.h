@@ -0,0 +1,208 @@
+#ifndef RATE_CONTROLLER_H
+#define RATE_CONTROLLER_H
+
+#include "latency_tracker.h"
+#include "worker_pool.h"
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+struct RateControllerConfig {
+    double min_hz = 0.5;
+    double max_hz = 10.0;
+    // The ship should not move farther than this between two position samples.
+    double max_travel_per_sample_m = 2.0;
+    // Samples wanted while the ship covers what is left of its margin to the threshold.
+    double samples_per_margin = 3.0;
+    // Incoming bytes/s the vehicle's own link carries (5760 is a 57600 baud radio) and the
+    // share of it telemetry that is being controlled may take, other traffic on that link
+    // included. 0 means the link is not the limit (SITL, Ethernet) and turns the cap off.
+    double link_budget_bytes_s = 0;
+    double max_link_share = 0.6;
+    // A busy link lowers the rate no further than this, or the motion rate if that is lower;
+    // set it to the fixed rate the vehicle would stream at without rate control.
+    double link_floor_hz = 1.0;
+    // Cost of one Hz of position plus attitude: GLOBAL_POSITION_INT and ATTITUDE, 28 byte
+    // payloads plus 12 bytes of MAVLink 2 framing each.
+    double bytes_per_hz = 80;
+    // Rates within this ratio of the current one are not requested again.
+    double change_ratio = 0.25;
+    // A higher rate is requested at once; a lower one only after it has been wanted for
+    // this long, so a ship that slows for a moment keeps its rate.
+    std::chrono::milliseconds lower_after{5000};
+};
+
+struct RateInputs {
+    // Estimated ship speed.
+    double speed_m_s;
+    // How far the ship still is from flipping the follow decision: |threshold - distance|,
+    // the smallest over the pairs that follow it.
+    double margin_m;
+    // Measured incoming bytes/s on the vehicle's own link, every vehicle sharing that link
+    // and every message included; negative while unknown.
+    double link_bytes_s;
+};
+
+enum class RateReason { Speed, Threshold, Minimum, Link };
+const char* rate_reason_name(RateReason reason);
+
+struct RateDecision {
+    double rate_hz;
+    // Which input set the rate.
+    RateReason reason;
+    // rate_hz should be requested from the vehicle.
+    bool change;
+};
+
+// The position/attitude rate one vehicle should stream at: fast enough that the ship moves
+// at most `max_travel_per_sample_m` per sample and reaches its threshold only after several
+// samples, within [min_hz, max_hz] and within what its link has left. Raises immediately,
+// lowers with a hold-off (see RateControllerConfig). Not thread-safe; one per vehicle.
+class RateController {
+public:
+    explicit RateController(double initial_hz, RateControllerConfig config = {});
+
+    RateDecision update(const RateInputs& inputs, int64_t now_ns);
+    // The rate the vehicle was asked for; the next update compares against it.
+    void applied(double rate_hz);
+
+    double rate_hz() const { return _rate_hz; }
+    const RateControllerConfig& config() const { return _config; }
+
+private:
+    RateControllerConfig _config;
+    double _rate_hz;
+    // Since when a lower rate has been wanted; 0 while not.
+    int64_t _lower_since_ns = 0;
+};
+
+// Counts incoming MAVLink bytes and position messages per source system. on_message() is
+// lock-free and meant for the link's receive thread; readers take differences.
+class LinkMeter {
+public:
+    void on_message(uint8_t sysid, std::size_t bytes, bool position) {
+        _bytes[sysid].fetch_add(bytes, std::memory_order_relaxed);
+        if (position) {
+            _positions[sysid].fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+
+    uint64_t bytes(uint8_t sysid) const { return _bytes[sysid].load(std::memory_order_relaxed); }
+    uint64_t positions(uint8_t sysid) const { return _positions[sysid].load(std::memory_order_relaxed); }
+    // Bytes from all of `sysids`, e.g. the vehicles behind one radio.
+    uint64_t bytes(const std::vector<uint8_t>& sysids) const {
+        uint64_t sum = 0;
+        for (const uint8_t sysid : sysids) {
+            sum += bytes(sysid);
+        }
+        return sum;
+    }
+
+private:
+    std::array<std::atomic<uint64_t>, 256> _bytes{};
+    std::array<std::atomic<uint64_t>, 256> _positions{};
+};
+
+struct RateChange {
+    uint8_t sysid;
+    int64_t time_ns;
+    double from_hz;
+    double to_hz;
+    RateReason reason;
+    RateInputs inputs;
+};
+
+// One rate compared with the one before it, each over the time it was in force (the new
+// one over `effect_window`, or less if it changed again sooner).
+struct RateEffect {
+    uint8_t sysid;
+    double from_hz;
+    double to_hz;
+    // Incoming bytes/s from the vehicle.
+    double bytes_s_before;
+    double bytes_s_after;
+    // Mean spacing of its position samples; 0 if none arrived.
+    double interval_ms_before;
+    double interval_ms_after;
+    // Total stage (ship fix -> ack) over the pairs following it; count 0 if none.
+    LatencySummary latency_before;
+    LatencySummary latency_after;
+};
+
+// Runs a RateController for one vehicle every `period` on a WorkerPool timer: reads the
+// motion inputs, measures its link (the bytes of the `link` sysids, which share that
+// vehicle's radio) from a LinkMeter, requests changed rates through
+// `set_rate` and reports each change and, `effect_window` later, its effect.
+class TelemetryRateLoop {
+public:
+    // Fills speed and margin; false while there is no estimate, which keeps the rate.
+    using InputSource = std::function<bool(RateInputs& inputs)>;
+    // Requests the rate from the vehicle without waiting for the answer; false if the
+    // request could not be sent. A refusal shows up in the measured link, not here.
+    using RateSetter = std::function<bool(double rate_hz)>;
+    using ChangeLog = std::function<void(const RateChange& change)>;
+    using EffectLog = std::function<void(const RateEffect& effect)>;
+
+    TelemetryRateLoop(uint8_t sysid, double initial_hz, RateControllerConfig config, const LinkMeter& meter,
+                      std::vector<uint8_t> link, const LatencyTracker* latency, std::vector<std::size_t> pairs, InputSource inputs,
+                      RateSetter set_rate, ChangeLog change_log = nullptr, EffectLog effect_log = nullptr,
+                      std::chrono::milliseconds effect_window = std::chrono::milliseconds(10000));
+
+    TelemetryRateLoop(const TelemetryRateLoop&) = delete;
+    TelemetryRateLoop& operator=(const TelemetryRateLoop&) = delete;
+
+    // Ticks run one at a time on `timers`, which must be stopped before the loop goes away.
+    void start(WorkerPool& timers, std::chrono::milliseconds period = std::chrono::milliseconds(1000));
+
+    uint8_t sysid() const { return _sysid; }
+    double rate_hz() const { return _rate_hz.load(std::memory_order_relaxed); }
+    uint64_t changes() const { return _changes.load(std::memory_order_relaxed); }
+
+private:
+    using Counts = std::array<uint64_t, LatencyHistogram::BUCKETS>;
+
+    // Counters at one point in time; an interval is the difference of two marks.
+    struct Mark {
+        int64_t time_ns = 0;
+        uint64_t bytes = 0;
+        uint64_t positions = 0;
+        Counts latency{};
+    };
+
+    void tick(WorkerPool& timers, WorkerPool::Clock::time_point when);
+    void mark(int64_t now_ns, Mark& out) const;
+    void report_effect(const Mark& now);
+
+    uint8_t _sysid;
+    RateController _controller;
+    const LinkMeter& _meter;
+    std::vector<uint8_t> _link;
+    const LatencyTracker* _latency;
+    std::vector<std::size_t> _pairs;
+    InputSource _inputs;
+    RateSetter _set_rate;
+    ChangeLog _change_log;
+    EffectLog _effect_log;
+    std::chrono::milliseconds _effect_window;
+    std::chrono::milliseconds _period{1000};
+
+    // Touched by the ticks only.
+    int64_t _last_tick_ns = 0;
+    uint64_t _last_link_bytes = 0;
+    double _link_bytes_s = -1;
+    // Start of the rate before the current one, start of the current one, and whether
+    // the current one's effect is still to be reported.
+    Mark _previous_start;
+    Mark _current_start;
+    double _previous_hz = 0;
+    bool _effect_pending = false;
+
+    std::atomic<double> _rate_hz;
+    std::atomic<uint64_t> _changes{0};
+};
+
+#endif // RATE_CONTROLLER_H
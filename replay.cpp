@@ -0,0 +1,115 @@
+#include "replay.h"
+#include <algorithm>
+
+ReplayEngine::ReplayEngine(ReplayConfig config, CommandSink sink) :
+    _config(config),
+    _sink(std::move(sink)),
+    _estimator(config.estimator),
+    _gate(config.threshold_m)
+{}
+
+void ReplayEngine::set_mission(MissionSync* mission_sync, const ShipPose& mission_origin) {
+    _mission_sync = mission_sync;
+    _mission_origin = mission_origin;
+    _mission_sync->set_origin(mission_origin);
+}
+
+void ReplayEngine::feed(const FlightRecord& record) {
+    // Everything due before this sample arrived runs first, with the state it had then.
+    // Samples stamped exactly at the due time are still picked up, as the live loop reads
+    // the freshest sample when it wakes.
+    if (_pending && record.time_ns > _due_ns) {
+        evaluate(_due_ns);
+    }
+    ++_stats.records;
+
+    const auto type = static_cast<RecordType>(record.type);
+    if (type == RecordType::Position &&
+        (_config.ship_sysid == 0 || record.source_sysid == _config.ship_sysid)) {
+        _ship = {record.latitude_deg, record.longitude_deg, record.altitude_m, record.time_ns};
+        _have_ship = true;
+        _ship_changed = true;
+        schedule(record.time_ns);
+    } else if (type == RecordType::Attitude &&
+               (_config.ship_sysid == 0 || record.source_sysid == _config.ship_sysid)) {
+        // Attitude alone does not trigger an evaluation, the latest one is folded into the next.
+        _attitude = {record.roll_deg, record.pitch_deg, record.yaw_deg, record.time_ns};
+        _attitude_changed = true;
+    } else if (type == RecordType::Home &&
+               (_config.drone_sysid == 0 || record.source_sysid == _config.drone_sysid)) {
+        if (_config.closed_loop_home && _have_home) {
+            return;
+        }
+        _home = {record.latitude_deg, record.longitude_deg, record.altitude_m, record.time_ns};
+        _have_home = true;
+        schedule(record.time_ns);
+    } else if (type == RecordType::HomeCommand &&
+               (_config.drone_sysid == 0 || record.target_sysid == _config.drone_sysid)) {
+        ++_stats.recorded_home_commands;
+    }
+}
+
+void ReplayEngine::finish() {
+    if (_pending) {
+        evaluate(_due_ns);
+    }
+}
+
+void ReplayEngine::schedule(int64_t time_ns) {
+    if (_pending || !_have_ship || !_have_home) {
+        return;
+    }
+    _pending = true;
+    _due_ns = time_ns;
+    if (_evaluated) {
+        const int64_t interval_ns = std::chrono::nanoseconds(_config.min_update_interval).count();
+        _due_ns = std::max(time_ns, _last_evaluation_ns + interval_ns);
+    }
+}
+
+void ReplayEngine::evaluate(int64_t time_ns) {
+    _pending = false;
+    if (_ship_changed) {
+        _estimator.update_position(_ship);
+    }
+    _ship_changed = false;
+    if (_attitude_changed) {
+        _estimator.update_attitude(_attitude);
+    }
+    _attitude_changed = false;
+    _last_evaluation_ns = time_ns;
+    _evaluated = true;
+    ++_stats.evaluations;
+
+    const ShipEstimate estimate = _estimator.predict(time_ns);
+    PositionSample target = _ship;
+    target.latitude_deg = estimate.latitude_deg;
+    target.longitude_deg = estimate.longitude_deg;
+
+    const FollowDecision decision = evaluate_follow(target, _home, _config.threshold_m);
+    if (!_gate.update(decision, target)) {
+        return;
+    }
+
+    ++_stats.home_commands;
+    _sink({ReplayCommand::Type::Home, time_ns, target.latitude_deg, target.longitude_deg, _config.home_altitude_m,
+           decision.distance_m, decision.bearing_deg, estimate.position_sigma_m, 0});
+    if (_config.closed_loop_home) {
+        _home = {target.latitude_deg, target.longitude_deg, _config.home_altitude_m, time_ns};
+    }
+
+    if (_mission_sync) {
+        const FollowGeodesy origin(_mission_origin.latitude_deg, _mission_origin.longitude_deg);
+        const double bearing = origin.bearing_deg(target.latitude_deg, target.longitude_deg);
+        const double distance_m = origin.distance_m(target.latitude_deg, target.longitude_deg);
+        const std::size_t items_before = _mission_sync->stats().items_sent;
+        // Until the ship reports an attitude it is taken to hold the origin heading.
+        const double heading = _attitude.time_ns != 0 ? _attitude.yaw_deg : _mission_origin.heading_deg;
+        if (_mission_sync->update({target.latitude_deg, target.longitude_deg, heading})) {
+            ++_stats.waypoint_updates;
+            _sink({ReplayCommand::Type::Waypoints, time_ns, target.latitude_deg, target.longitude_deg,
+                   _config.home_altitude_m, distance_m, bearing, estimate.position_sigma_m,
+                   _mission_sync->stats().items_sent - items_before});
+        }
+    }
+}
@@ -0,0 +1,103 @@
+#ifndef REPLAY_H
+#define REPLAY_H
+
+#include "flight_recorder.h"
+#include "follow_logic.h"
+#include "mission_sync.h"
+#include "ship_estimator.h"
+#include "telemetry_slot.h"
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+struct ReplayConfig {
+    // Records from other vehicles are ignored; 0 accepts any sysid (single-pair logs).
+    uint8_t ship_sysid = 0;
+    uint8_t drone_sysid = 0;
+    float threshold_m = 10;
+    std::chrono::milliseconds min_update_interval{200};
+    float home_altitude_m = 0;
+    // Apply every command to the drone home at once instead of waiting for the recorded
+    // home report. Use this when the logic under test sends different commands than the
+    // run that was recorded.
+    bool closed_loop_home = false;
+    ShipEstimatorConfig estimator;
+};
+
+// One command the follow logic sent during replay.
+struct ReplayCommand {
+    enum class Type { Home, Waypoints };
+
+    Type type;
+    int64_t time_ns;
+    double latitude_deg;
+    double longitude_deg;
+    float altitude_m;
+    double distance_m;
+    double bearing_deg;
+    double position_sigma_m;
+    // Waypoints only: mission items pushed to the vehicle by this update.
+    std::size_t items_sent;
+};
+
+struct ReplayStats {
+    uint64_t records = 0;
+    uint64_t evaluations = 0;
+    uint64_t home_commands = 0;
+    uint64_t waypoint_updates = 0;
+    // HomeCommand records already present in the input, for comparison.
+    uint64_t recorded_home_commands = 0;
+};
+
+// Runs recorded telemetry through the single-pair follow loop of takeoff_and_land on a
+// virtual clock: samples are applied at their recorded time, an evaluation runs when a
+// position or home changes (no sooner than min_update_interval after the previous one)
+// and the clock jumps straight to the next event, so a replay is as fast as the CPU
+// allows and gives the same command stream every time.
+class ReplayEngine {
+public:
+    using CommandSink = std::function<void(const ReplayCommand& command)>;
+
+    ReplayEngine(ReplayConfig config, CommandSink sink);
+
+    // Also moves this mission along with every home command, like update_waypoints(),
+    // turning it with the ship's latest heading. `mission_origin` is the ship pose the
+    // mission was planned around.
+    void set_mission(MissionSync* mission_sync, const ShipPose& mission_origin);
+
+    // Records must come in time order.
+    void feed(const FlightRecord& record);
+    // Runs the evaluation still pending at the end of the log.
+    void finish();
+
+    const ReplayStats& stats() const { return _stats; }
+
+private:
+    void evaluate(int64_t time_ns);
+    void schedule(int64_t time_ns);
+
+    ReplayConfig _config;
+    CommandSink _sink;
+    MissionSync* _mission_sync = nullptr;
+    ShipPose _mission_origin{};
+
+    PositionSample _ship{};
+    PositionSample _home{};
+    AttitudeSample _attitude{};
+    bool _have_ship = false;
+    bool _have_home = false;
+    bool _ship_changed = false;
+    bool _attitude_changed = false;
+    ShipEstimator _estimator;
+    FollowGate _gate;
+
+    bool _pending = false;
+    int64_t _due_ns = 0;
+    int64_t _last_evaluation_ns = 0;
+    bool _evaluated = false;
+
+    ReplayStats _stats;
+};
+
+#endif // REPLAY_H
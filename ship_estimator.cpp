@@ -0,0 +1,195 @@
+#include "ship_estimator.h"
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+const double EARTH_RADIUS_M = 6371000.0;
+const double INITIAL_SPEED_SIGMA_M_S = 10.0;
+
+double wrap_pi(double angle) {
+    angle = std::fmod(angle + M_PI, 2 * M_PI);
+    if (angle < 0) {
+        angle += 2 * M_PI;
+    }
+    return angle - M_PI;
+}
+
+void symmetrize(double p[4][4]) {
+    for (int i = 0; i < 4; ++i) {
+        for (int j = i + 1; j < 4; ++j) {
+            const double mean = 0.5 * (p[i][j] + p[j][i]);
+            p[i][j] = mean;
+            p[j][i] = mean;
+        }
+    }
+}
+
+} // namespace
+
+ShipEstimator::ShipEstimator(ShipEstimatorConfig config) :
+    _config(config)
+{}
+
+void ShipEstimator::propagate(double dt, double x[4], double p[4][4]) const {
+    x[0] += x[2] * dt;
+    x[1] += x[3] * dt;
+
+    // P = F P F^T with F = [I dt*I; 0 I]
+    for (int j = 0; j < 4; ++j) {
+        p[0][j] += dt * p[2][j];
+        p[1][j] += dt * p[3][j];
+    }
+    for (int i = 0; i < 4; ++i) {
+        p[i][0] += dt * p[i][2];
+        p[i][1] += dt * p[i][3];
+    }
+
+    // + Q for white-noise acceleration, independently per axis
+    const double q = _config.acceleration_noise;
+    const double q_pp = q * dt * dt * dt / 3;
+    const double q_pv = q * dt * dt / 2;
+    const double q_vv = q * dt;
+    for (int axis = 0; axis < 2; ++axis) {
+        p[axis][axis] += q_pp;
+        p[axis][axis + 2] += q_pv;
+        p[axis + 2][axis] += q_pv;
+        p[axis + 2][axis + 2] += q_vv;
+    }
+}
+
+void ShipEstimator::advance_to(int64_t time_ns) {
+    const double dt = (time_ns - _time_ns) / 1e9;
+    if (dt <= 0) {
+        return;
+    }
+    propagate(dt, _x, _p);
+    _time_ns = time_ns;
+}
+
+void ShipEstimator::update_position(const PositionSample& sample) {
+    if (!_initialized || (sample.time_ns - _last_fix_ns) / 1e9 > _config.reset_after_s) {
+        _ref_lat_deg = sample.latitude_deg;
+        _ref_lon_deg = sample.longitude_deg;
+        _meters_per_deg_lat = EARTH_RADIUS_M * M_PI / 180.0;
+        _meters_per_deg_lon = _meters_per_deg_lat * std::cos(sample.latitude_deg * M_PI / 180.0);
+
+        const double pos_var = _config.position_sigma_m * _config.position_sigma_m;
+        const double vel_var = INITIAL_SPEED_SIGMA_M_S * INITIAL_SPEED_SIGMA_M_S;
+        for (int i = 0; i < 4; ++i) {
+            _x[i] = 0;
+            for (int j = 0; j < 4; ++j) {
+                _p[i][j] = 0;
+            }
+        }
+        _p[0][0] = _p[1][1] = pos_var;
+        _p[2][2] = _p[3][3] = vel_var;
+        _time_ns = sample.time_ns;
+        _last_fix_ns = sample.time_ns;
+        _initialized = true;
+        return;
+    }
+
+    advance_to(sample.time_ns);
+
+    const double north = (sample.latitude_deg - _ref_lat_deg) * _meters_per_deg_lat;
+    const double east = (sample.longitude_deg - _ref_lon_deg) * _meters_per_deg_lon;
+    const double y0 = north - _x[0];
+    const double y1 = east - _x[1];
+
+    // S = H P H^T + R, H selects the position; invert the 2x2 directly.
+    const double r = _config.position_sigma_m * _config.position_sigma_m;
+    const double s00 = _p[0][0] + r;
+    const double s01 = _p[0][1];
+    const double s11 = _p[1][1] + r;
+    const double det = s00 * s11 - s01 * s01;
+    const double i00 = s11 / det;
+    const double i01 = -s01 / det;
+    const double i11 = s00 / det;
+
+    double k[4][2];
+    for (int i = 0; i < 4; ++i) {
+        k[i][0] = _p[i][0] * i00 + _p[i][1] * i01;
+        k[i][1] = _p[i][0] * i01 + _p[i][1] * i11;
+    }
+    for (int i = 0; i < 4; ++i) {
+        _x[i] += k[i][0] * y0 + k[i][1] * y1;
+    }
+
+    double hp[2][4];
+    for (int j = 0; j < 4; ++j) {
+        hp[0][j] = _p[0][j];
+        hp[1][j] = _p[1][j];
+    }
+    for (int i = 0; i < 4; ++i) {
+        for (int j = 0; j < 4; ++j) {
+            _p[i][j] -= k[i][0] * hp[0][j] + k[i][1] * hp[1][j];
+        }
+    }
+    symmetrize(_p);
+    _last_fix_ns = sample.time_ns;
+}
+
+void ShipEstimator::update_attitude(const AttitudeSample& sample) {
+    if (!_initialized) {
+        return;
+    }
+    advance_to(sample.time_ns);
+
+    const double speed_sq = _x[2] * _x[2] + _x[3] * _x[3];
+    const double min_speed = _config.min_speed_for_heading_m_s;
+    if (speed_sq < min_speed * min_speed) {
+        return;
+    }
+
+    // h(x) = atan2(v_east, v_north), linearized around the current velocity.
+    const double sigma = _config.heading_sigma_deg * M_PI / 180.0;
+    const double innovation = wrap_pi(sample.yaw_deg * M_PI / 180.0 - std::atan2(_x[3], _x[2]));
+    if (std::fabs(innovation) > 3 * sigma) {
+        // Yaw and course disagree (drift, current, a vehicle that does not point where it goes).
+        return;
+    }
+    const double h2 = -_x[3] / speed_sq;
+    const double h3 = _x[2] / speed_sq;
+
+    double ph[4];
+    for (int i = 0; i < 4; ++i) {
+        ph[i] = _p[i][2] * h2 + _p[i][3] * h3;
+    }
+    const double s = h2 * ph[2] + h3 * ph[3] + sigma * sigma;
+    for (int i = 0; i < 4; ++i) {
+        _x[i] += ph[i] / s * innovation;
+    }
+    for (int i = 0; i < 4; ++i) {
+        for (int j = 0; j < 4; ++j) {
+            _p[i][j] -= ph[i] * ph[j] / s;
+        }
+    }
+    symmetrize(_p);
+}
+
+ShipEstimate ShipEstimator::predict(int64_t time_ns) const {
+    ShipEstimate estimate{};
+    if (!_initialized) {
+        return estimate;
+    }
+
+    const int64_t horizon_end = _last_fix_ns + static_cast<int64_t>(_config.max_extrapolation_s * 1e9);
+    const double dt = std::max<int64_t>(0, std::min(time_ns, horizon_end) - _time_ns) / 1e9;
+
+    double x[4];
+    double p[4][4];
+    std::copy(_x, _x + 4, x);
+    for (int i = 0; i < 4; ++i) {
+        std::copy(_p[i], _p[i] + 4, p[i]);
+    }
+    propagate(dt, x, p);
+
+    estimate.valid = true;
+    estimate.latitude_deg = _ref_lat_deg + x[0] / _meters_per_deg_lat;
+    estimate.longitude_deg = _ref_lon_deg + x[1] / _meters_per_deg_lon;
+    estimate.north_m_s = x[2];
+    estimate.east_m_s = x[3];
+    estimate.position_sigma_m = std::sqrt(p[0][0] + p[1][1]);
+    return estimate;
+}
@@ -0,0 +1,69 @@
+#ifndef SHIP_ESTIMATOR_H
+#define SHIP_ESTIMATOR_H
+
+#include "telemetry_slot.h"
+#include <cstdint>
+
+struct ShipEstimatorConfig {
+    // White-noise acceleration spectral density, (m/s^2)^2 per second.
+    double acceleration_noise = 0.25;
+    // 1-sigma noise of a GLOBAL_POSITION_INT fix as received, meters.
+    double position_sigma_m = 2.0;
+    // 1-sigma noise of the heading pseudo-measurement taken from the attitude yaw.
+    double heading_sigma_deg = 10.0;
+    // Yaw only constrains the velocity direction once the ship is actually moving.
+    double min_speed_for_heading_m_s = 1.0;
+    // Predictions never extrapolate further than this past the last fix.
+    double max_extrapolation_s = 5.0;
+    // A gap longer than this restarts the filter from the next fix.
+    double reset_after_s = 10.0;
+};
+
+struct ShipEstimate {
+    bool valid;
+    double latitude_deg;
+    double longitude_deg;
+    double north_m_s;
+    double east_m_s;
+    // Radial 1-sigma position uncertainty at the prediction time.
+    double position_sigma_m;
+};
+
+// Constant-velocity Kalman filter for the ship, run in a local north/east plane around
+// its first fix. Fed by the position and attitude streams (yaw acts as a heading
+// measurement on the velocity), it extrapolates the position to the time a command is
+// sent so a low telemetry rate does not leave the home behind a moving ship.
+// Times are the monotonic receipt stamps of the samples; the filter has no clock of
+// its own, so replaying the same samples gives the same estimates.
+class ShipEstimator {
+public:
+    explicit ShipEstimator(ShipEstimatorConfig config = {});
+
+    void update_position(const PositionSample& sample);
+    void update_attitude(const AttitudeSample& sample);
+
+    // Estimate at `time_ns` without changing the filter state.
+    ShipEstimate predict(int64_t time_ns) const;
+
+    bool initialized() const { return _initialized; }
+    void reset() { _initialized = false; }
+
+private:
+    // Propagates state and covariance by dt seconds into x / p.
+    void propagate(double dt, double x[4], double p[4][4]) const;
+    void advance_to(int64_t time_ns);
+
+    ShipEstimatorConfig _config;
+    bool _initialized = false;
+    int64_t _time_ns = 0;
+    int64_t _last_fix_ns = 0;
+    double _ref_lat_deg = 0;
+    double _ref_lon_deg = 0;
+    double _meters_per_deg_lat = 0;
+    double _meters_per_deg_lon = 0;
+    // state: north, east (m), north, east velocity (m/s)
+    double _x[4] = {};
+    double _p[4][4] = {};
+};
+
+#endif // SHIP_ESTIMATOR_H
@@ -0,0 +1,514 @@
+#include "sim_vehicle.h"
+#include "coordinates.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace {
+
+const uint8_t COMPONENT_ID = MAV_COMP_ID_AUTOPILOT1;
+const uint8_t CHANNEL = MAVLINK_COMM_0;
+const int64_t MISSION_RETRY_NS = 250000000;
+const int MISSION_MAX_RETRIES = 5;
+
+// Swell seen by a ship: a few degrees of roll and pitch with different periods.
+const double ROLL_AMPLITUDE_DEG = 3.0;
+const double ROLL_PERIOD_S = 8.0;
+const double PITCH_AMPLITUDE_DEG = 1.5;
+const double PITCH_PERIOD_S = 6.5;
+
+int64_t interval_ns(double rate_hz) {
+    return rate_hz > 0 ? static_cast<int64_t>(1e9 / rate_hz) : -1;
+}
+
+bool addressed_to(uint8_t target_system, uint8_t sysid) {
+    return target_system == 0 || target_system == sysid;
+}
+
+double deg_to_rad(double degrees) {
+    return degrees * M_PI / 180.0;
+}
+
+double wrap_360(double degrees) {
+    degrees = std::fmod(degrees, 360.0);
+    return degrees < 0 ? degrees + 360.0 : degrees;
+}
+
+} // namespace
+
+SimState sim_track_state(const SimTrack& track, double time_s) {
+    SimState state{track.latitude_deg, track.longitude_deg, track.altitude_m, 0, 0,
+                   static_cast<float>(wrap_360(track.heading_deg))};
+    const std::vector<double> start = {track.latitude_deg, track.longitude_deg};
+
+    switch (track.kind) {
+        case SimTrack::Kind::Stationary:
+            break;
+        case SimTrack::Kind::Line: {
+            const std::vector<double> position =
+                translate_coordinates(start, track.heading_deg, track.speed_m_s * time_s / 1000.0);
+            state.latitude_deg = position[0];
+            state.longitude_deg = position[1];
+            state.north_m_s = static_cast<float>(track.speed_m_s * std::cos(deg_to_rad(track.heading_deg)));
+            state.east_m_s = static_cast<float>(track.speed_m_s * std::sin(deg_to_rad(track.heading_deg)));
+            break;
+        }
+        case SimTrack::Kind::Circle: {
+            if (track.radius_m <= 0) {
+                break;
+            }
+            // Bearing from the center grows clockwise; the course is 90 degrees ahead of it.
+            const double bearing = std::fmod(track.speed_m_s * time_s / track.radius_m * 180.0 / M_PI, 360.0);
+            const std::vector<double> position = translate_coordinates(start, bearing, track.radius_m / 1000.0);
+            const double course = wrap_360(bearing + 90.0);
+            state.latitude_deg = position[0];
+            state.longitude_deg = position[1];
+            state.north_m_s = static_cast<float>(track.speed_m_s * std::cos(deg_to_rad(course)));
+            state.east_m_s = static_cast<float>(track.speed_m_s * std::sin(deg_to_rad(course)));
+            state.heading_deg = static_cast<float>(course);
+            break;
+        }
+    }
+    return state;
+}
+
+SimVehicle::SimVehicle(SimVehicleConfig config, Sink sink) :
+    _config(config),
+    _sink(std::move(sink)),
+    _heartbeat{interval_ns(1.0), 0},
+    _position{interval_ns(config.position_rate_hz), 0},
+    _attitude{interval_ns(config.attitude_rate_hz), 0},
+    _home_stream{interval_ns(config.home_rate_hz), 0}
+{
+    const SimState start = sim_track_state(config.track, 0);
+    _home_latitude_deg = start.latitude_deg;
+    _home_longitude_deg = start.longitude_deg;
+    _home_altitude_m = start.altitude_m;
+}
+
+int64_t SimVehicle::next_due_ns() const {
+    int64_t due = std::numeric_limits<int64_t>::max();
+    for (const Stream* stream : {&_heartbeat, &_position, &_attitude, &_home_stream}) {
+        if (stream->interval_ns > 0) {
+            due = std::min(due, stream->next_ns);
+        }
+    }
+    if (_receiving) {
+        due = std::min(due, _last_request_ns + MISSION_RETRY_NS);
+    }
+    return due;
+}
+
+void SimVehicle::tick(int64_t time_ns) {
+    // A stream that fell behind (stalled loop, rate change) restarts from now instead of bursting.
+    auto due = [time_ns](Stream& stream) {
+        if (stream.interval_ns <= 0 || time_ns < stream.next_ns) {
+            return false;
+        }
+        stream.next_ns += stream.interval_ns;
+        if (stream.next_ns <= time_ns) {
+            stream.next_ns = time_ns + stream.interval_ns;
+        }
+        return true;
+    };
+
+    if (due(_heartbeat)) {
+        send_heartbeat();
+    }
+    if (due(_position)) {
+        send_position(time_ns);
+    }
+    if (due(_attitude)) {
+        send_attitude(time_ns);
+    }
+    if (due(_home_stream)) {
+        send_home(time_ns);
+    }
+
+    if (_receiving && time_ns - _last_request_ns >= MISSION_RETRY_NS) {
+        if (_request_retries >= MISSION_MAX_RETRIES) {
+            _receiving = false;
+            send_mission_ack(_partner_sysid, _partner_compid, MAV_MISSION_OPERATION_CANCELLED,
+                             MAV_MISSION_TYPE_MISSION);
+        } else {
+            ++_request_retries;
+            request_mission_item(time_ns);
+        }
+    }
+}
+
+void SimVehicle::handle(const mavlink_message_t& message, int64_t time_ns) {
+    switch (message.msgid) {
+        case MAVLINK_MSG_ID_COMMAND_LONG: {
+            mavlink_command_long_t command;
+            mavlink_msg_command_long_decode(&message, &command);
+            if (!addressed_to(command.target_system, _config.sysid)) {
+                return;
+            }
+            const float params[7] = {command.param1, command.param2, command.param3, command.param4,
+                                     command.param5, command.param6, command.param7};
+            handle_command(command.command, params, 0, 0, false, message, time_ns);
+            break;
+        }
+        case MAVLINK_MSG_ID_COMMAND_INT: {
+            mavlink_command_int_t command;
+            mavlink_msg_command_int_decode(&message, &command);
+            if (!addressed_to(command.target_system, _config.sysid)) {
+                return;
+            }
+            const float params[7] = {command.param1, command.param2, command.param3, command.param4,
+                                     0, 0, command.z};
+            handle_command(command.command, params, command.x, command.y, true, message, time_ns);
+            break;
+        }
+        default:
+            handle_mission(message, time_ns);
+            break;
+    }
+}
+
+void SimVehicle::handle_command(uint16_t command, const float params[7], int32_t x, int32_t y, bool is_int,
+                                const mavlink_message_t& message, int64_t time_ns) {
+    uint8_t result = MAV_RESULT_ACCEPTED;
+    switch (command) {
+        case MAV_CMD_DO_SET_HOME: {
+            ++_stats.set_home_commands;
+            if (params[0] == 1) {
+                const SimState state = sim_track_state(_config.track, time_ns / 1e9);
+                _home_latitude_deg = state.latitude_deg;
+                _home_longitude_deg = state.longitude_deg;
+                _home_altitude_m = state.altitude_m;
+            } else {
+                const double latitude_deg = is_int ? x * 1e-7 : params[4];
+                const double longitude_deg = is_int ? y * 1e-7 : params[5];
+                if (!std::isfinite(latitude_deg) || !std::isfinite(longitude_deg) || std::fabs(latitude_deg) > 90 ||
+                    std::fabs(longitude_deg) > 180) {
+                    result = MAV_RESULT_DENIED;
+                    break;
+                }
+                _home_latitude_deg = latitude_deg;
+                _home_longitude_deg = longitude_deg;
+                _home_altitude_m = params[6];
+            }
+            send_ack(command, result, message);
+            // The autopilot reports the new home right away, which is what closes the follow loop.
+            send_home(time_ns);
+            return;
+        }
+        case MAV_CMD_SET_MESSAGE_INTERVAL:
+            result = set_interval(static_cast<uint32_t>(params[0]), params[1]) ? MAV_RESULT_ACCEPTED
+                                                                                 : MAV_RESULT_UNSUPPORTED;
+            break;
+        case MAV_CMD_REQUEST_MESSAGE:
+            if (static_cast<uint32_t>(params[0]) == MAVLINK_MSG_ID_HOME_POSITION) {
+                send_ack(command, result, message);
+                send_home(time_ns);
+                return;
+            }
+            if (static_cast<uint32_t>(params[0]) == MAVLINK_MSG_ID_AUTOPILOT_VERSION) {
+                send_ack(command, result, message);
+                send_autopilot_version();
+                return;
+            }
+            result = MAV_RESULT_UNSUPPORTED;
+            break;
+        case MAV_CMD_REQUEST_AUTOPILOT_CAPABILITIES:
+            send_ack(command, result, message);
+            send_autopilot_version();
+            return;
+        case MAV_CMD_GET_HOME_POSITION:
+            send_ack(command, result, message);
+            send_home(time_ns);
+            return;
+        default:
+            result = MAV_RESULT_UNSUPPORTED;
+            break;
+    }
+    send_ack(command, result, message);
+}
+
+void SimVehicle::handle_mission(const mavlink_message_t& message, int64_t time_ns) {
+    switch (message.msgid) {
+        case MAVLINK_MSG_ID_MISSION_COUNT: {
+            mavlink_mission_count_t count;
+            mavlink_msg_mission_count_decode(&message, &count);
+            if (!addressed_to(count.target_system, _config.sysid)) {
+                return;
+            }
+            if (count.mission_type != MAV_MISSION_TYPE_MISSION) {
+                // No geofence or rally support, but an empty one is fine.
+                send_mission_ack(message.sysid, message.compid,
+                                 count.count == 0 ? MAV_MISSION_ACCEPTED : MAV_MISSION_UNSUPPORTED,
+                                 count.mission_type);
+                return;
+            }
+            if (count.count == 0) {
+                _mission.clear();
+                _receiving = false;
+                ++_stats.mission_uploads;
+                send_mission_ack(message.sysid, message.compid, MAV_MISSION_ACCEPTED, count.mission_type);
+                return;
+            }
+            _staged.assign(count.count, mavlink_mission_item_int_t{});
+            _receiving = true;
+            _partial = false;
+            _next_seq = 0;
+            _end_seq = count.count - 1;
+            _partner_sysid = message.sysid;
+            _partner_compid = message.compid;
+            _request_retries = 0;
+            request_mission_item(time_ns);
+            break;
+        }
+        case MAVLINK_MSG_ID_MISSION_WRITE_PARTIAL_LIST: {
+            mavlink_mission_write_partial_list_t partial;
+            mavlink_msg_mission_write_partial_list_decode(&message, &partial);
+            if (!addressed_to(partial.target_system, _config.sysid)) {
+                return;
+            }
+            if (partial.mission_type != MAV_MISSION_TYPE_MISSION || partial.start_index < 0 ||
+                partial.end_index < partial.start_index ||
+                static_cast<std::size_t>(partial.end_index) >= _mission.size()) {
+                send_mission_ack(message.sysid, message.compid, MAV_MISSION_ERROR, partial.mission_type);
+                return;
+            }
+            _staged = _mission;
+            _receiving = true;
+            _partial = true;
+            _next_seq = static_cast<uint16_t>(partial.start_index);
+            _end_seq = static_cast<uint16_t>(partial.end_index);
+            _partner_sysid = message.sysid;
+            _partner_compid = message.compid;
+            _request_retries = 0;
+            request_mission_item(time_ns);
+            break;
+        }
+        case MAVLINK_MSG_ID_MISSION_ITEM_INT: {
+            mavlink_mission_item_int_t item;
+            mavlink_msg_mission_item_int_decode(&message, &item);
+            if (!addressed_to(item.target_system, _config.sysid) || !_receiving ||
+                item.mission_type != MAV_MISSION_TYPE_MISSION) {
+                return;
+            }
+            if (item.seq != _next_seq) {
+                // Duplicate or out of order (our request or their item was lost): ask again.
+                request_mission_item(time_ns);
+                return;
+            }
+            _staged[item.seq] = item;
+            ++_stats.mission_items_received;
+            if (item.seq == _end_seq) {
+                _mission.swap(_staged);
+                _receiving = false;
+                if (_partial) {
+                    ++_stats.partial_writes;
+                } else {
+                    ++_stats.mission_uploads;
+                }
+                send_mission_ack(message.sysid, message.compid, MAV_MISSION_ACCEPTED, MAV_MISSION_TYPE_MISSION);
+                return;
+            }
+            ++_next_seq;
+            _request_retries = 0;
+            request_mission_item(time_ns);
+            break;
+        }
+        case MAVLINK_MSG_ID_MISSION_REQUEST_LIST: {
+            mavlink_mission_request_list_t request;
+            mavlink_msg_mission_request_list_decode(&message, &request);
+            if (!addressed_to(request.target_system, _config.sysid)) {
+                return;
+            }
+            mavlink_mission_count_t count{};
+            count.target_system = message.sysid;
+            count.target_component = message.compid;
+            count.mission_type = request.mission_type;
+            count.count = request.mission_type == MAV_MISSION_TYPE_MISSION ? static_cast<uint16_t>(_mission.size()) : 0;
+            mavlink_message_t reply;
+            mavlink_msg_mission_count_encode_chan(_config.sysid, COMPONENT_ID, CHANNEL, &reply, &count);
+            send(reply);
+            break;
+        }
+        case MAVLINK_MSG_ID_MISSION_REQUEST_INT:
+        case MAVLINK_MSG_ID_MISSION_REQUEST: {
+            // The float MISSION_REQUEST is answered with MISSION_ITEM_INT as well, as PX4 does.
+            mavlink_mission_request_int_t request;
+            if (message.msgid == MAVLINK_MSG_ID_MISSION_REQUEST_INT) {
+                mavlink_msg_mission_request_int_decode(&message, &request);
+            } else {
+                mavlink_mission_request_t legacy;
+                mavlink_msg_mission_request_decode(&message, &legacy);
+                request.seq = legacy.seq;
+                request.target_system = legacy.target_system;
+                request.target_component = legacy.target_component;
+                request.mission_type = legacy.mission_type;
+            }
+            if (!addressed_to(request.target_system, _config.sysid)) {
+                return;
+            }
+            if (request.mission_type != MAV_MISSION_TYPE_MISSION || request.seq >= _mission.size()) {
+                send_mission_ack(message.sysid, message.compid, MAV_MISSION_INVALID_SEQUENCE, request.mission_type);
+                return;
+            }
+            mavlink_mission_item_int_t item = _mission[request.seq];
+            item.target_system = message.sysid;
+            item.target_component = message.compid;
+            mavlink_message_t reply;
+            mavlink_msg_mission_item_int_encode_chan(_config.sysid, COMPONENT_ID, CHANNEL, &reply, &item);
+            send(reply);
+            break;
+        }
+        case MAVLINK_MSG_ID_MISSION_CLEAR_ALL: {
+            mavlink_mission_clear_all_t clear;
+            mavlink_msg_mission_clear_all_decode(&message, &clear);
+            if (!addressed_to(clear.target_system, _config.sysid)) {
+                return;
+            }
+            if (clear.mission_type == MAV_MISSION_TYPE_MISSION || clear.mission_type == MAV_MISSION_TYPE_ALL) {
+                _mission.clear();
+                _receiving = false;
+            }
+            send_mission_ack(message.sysid, message.compid, MAV_MISSION_ACCEPTED, clear.mission_type);
+            break;
+        }
+        default:
+            break;
+    }
+}
+
+void SimVehicle::send(const mavlink_message_t& message) {
+    ++_stats.messages_sent;
+    _sink(message);
+}
+
+void SimVehicle::send_ack(uint16_t command, uint8_t result, const mavlink_message_t& to) {
+    mavlink_command_ack_t ack{};
+    ack.command = command;
+    ack.result = result;
+    ack.target_system = to.sysid;
+    ack.target_component = to.compid;
+    mavlink_message_t message;
+    mavlink_msg_command_ack_encode_chan(_config.sysid, COMPONENT_ID, CHANNEL, &message, &ack);
+    send(message);
+}
+
+void SimVehicle::send_heartbeat() {
+    mavlink_heartbeat_t heartbeat{};
+    heartbeat.type = _config.ship ? MAV_TYPE_SURFACE_BOAT : MAV_TYPE_QUADROTOR;
+    heartbeat.autopilot = MAV_AUTOPILOT_GENERIC;
+    heartbeat.base_mode = MAV_MODE_FLAG_CUSTOM_MODE_ENABLED;
+    heartbeat.system_status = MAV_STATE_ACTIVE;
+    heartbeat.mavlink_version = 3;
+    mavlink_message_t message;
+    mavlink_msg_heartbeat_encode_chan(_config.sysid, COMPONENT_ID, CHANNEL, &message, &heartbeat);
+    send(message);
+}
+
+void SimVehicle::send_autopilot_version() {
+    mavlink_autopilot_version_t version{};
+    version.capabilities = MAV_PROTOCOL_CAPABILITY_MISSION_INT | MAV_PROTOCOL_CAPABILITY_COMMAND_INT |
+                           MAV_PROTOCOL_CAPABILITY_MAVLINK2;
+    version.uid = _config.sysid;
+    mavlink_message_t message;
+    mavlink_msg_autopilot_version_encode_chan(_config.sysid, COMPONENT_ID, CHANNEL, &message, &version);
+    send(message);
+}
+
+void SimVehicle::send_position(int64_t time_ns) {
+    const SimState state = sim_track_state(_config.track, time_ns / 1e9);
+    mavlink_global_position_int_t position{};
+    position.time_boot_ms = static_cast<uint32_t>(time_ns / 1000000);
+    position.lat = static_cast<int32_t>(std::lround(state.latitude_deg * 1e7));
+    position.lon = static_cast<int32_t>(std::lround(state.longitude_deg * 1e7));
+    position.alt = static_cast<int32_t>(std::lround(state.altitude_m * 1000.0));
+    position.relative_alt = static_cast<int32_t>(std::lround((state.altitude_m - _home_altitude_m) * 1000.0));
+    position.vx = static_cast<int16_t>(std::lround(state.north_m_s * 100.0));
+    position.vy = static_cast<int16_t>(std::lround(state.east_m_s * 100.0));
+    position.hdg = static_cast<uint16_t>(std::lround(state.heading_deg * 100.0) % 36000);
+    mavlink_message_t message;
+    mavlink_msg_global_position_int_encode_chan(_config.sysid, COMPONENT_ID, CHANNEL, &message, &position);
+    send(message);
+}
+
+void SimVehicle::send_attitude(int64_t time_ns) {
+    const double time_s = time_ns / 1e9;
+    const SimState state = sim_track_state(_config.track, time_s);
+    mavlink_attitude_t attitude{};
+    attitude.time_boot_ms = static_cast<uint32_t>(time_ns / 1000000);
+    if (_config.ship) {
+        attitude.roll = static_cast<float>(deg_to_rad(ROLL_AMPLITUDE_DEG * std::sin(2 * M_PI * time_s / ROLL_PERIOD_S)));
+        attitude.pitch =
+            static_cast<float>(deg_to_rad(PITCH_AMPLITUDE_DEG * std::sin(2 * M_PI * time_s / PITCH_PERIOD_S)));
+    }
+    // MAVLink yaw is -pi..pi
+    const double heading = state.heading_deg > 180 ? state.heading_deg - 360.0 : state.heading_deg;
+    attitude.yaw = static_cast<float>(deg_to_rad(heading));
+    mavlink_message_t message;
+    mavlink_msg_attitude_encode_chan(_config.sysid, COMPONENT_ID, CHANNEL, &message, &attitude);
+    send(message);
+}
+
+void SimVehicle::send_home(int64_t time_ns) {
+    mavlink_home_position_t home{};
+    home.latitude = static_cast<int32_t>(std::lround(_home_latitude_deg * 1e7));
+    home.longitude = static_cast<int32_t>(std::lround(_home_longitude_deg * 1e7));
+    home.altitude = static_cast<int32_t>(std::lround(_home_altitude_m * 1000.0));
+    home.q[0] = 1;
+    home.time_usec = static_cast<uint64_t>(time_ns / 1000);
+    mavlink_message_t message;
+    mavlink_msg_home_position_encode_chan(_config.sysid, COMPONENT_ID, CHANNEL, &message, &home);
+    send(message);
+}
+
+void SimVehicle::send_mission_ack(uint8_t target_sysid, uint8_t target_compid, uint8_t type, uint8_t mission_type) {
+    mavlink_mission_ack_t ack{};
+    ack.target_system = target_sysid;
+    ack.target_component = target_compid;
+    ack.type = type;
+    ack.mission_type = mission_type;
+    mavlink_message_t message;
+    mavlink_msg_mission_ack_encode_chan(_config.sysid, COMPONENT_ID, CHANNEL, &message, &ack);
+    send(message);
+}
+
+void SimVehicle::request_mission_item(int64_t time_ns) {
+    mavlink_mission_request_int_t request{};
+    request.target_system = _partner_sysid;
+    request.target_component = _partner_compid;
+    request.seq = _next_seq;
+    request.mission_type = MAV_MISSION_TYPE_MISSION;
+    mavlink_message_t message;
+    mavlink_msg_mission_request_int_encode_chan(_config.sysid, COMPONENT_ID, CHANNEL, &message, &request);
+    send(message);
+    _last_request_ns = time_ns;
+}
+
+bool SimVehicle::set_interval(uint32_t message_id, double interval_us) {
+    Stream* stream = nullptr;
+    double default_rate_hz = 0;
+    switch (message_id) {
+        case MAVLINK_MSG_ID_GLOBAL_POSITION_INT:
+            stream = &_position;
+            default_rate_hz = _config.position_rate_hz;
+            break;
+        case MAVLINK_MSG_ID_ATTITUDE:
+            stream = &_attitude;
+            default_rate_hz = _config.attitude_rate_hz;
+            break;
+        case MAVLINK_MSG_ID_HOME_POSITION:
+            stream = &_home_stream;
+            default_rate_hz = _config.home_rate_hz;
+            break;
+        default:
+            return false;
+    }
+    // -1 disables the stream, 0 restores the configured rate.
+    if (interval_us < 0) {
+        stream->interval_ns = -1;
+    } else if (interval_us == 0) {
+        stream->interval_ns = interval_ns(default_rate_hz);
+    } else {
+        stream->interval_ns = static_cast<int64_t>(interval_us * 1000.0);
+    }
+    return true;
+}
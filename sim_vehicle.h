@@ -0,0 +1,122 @@
+#ifndef SIM_VEHICLE_H
+#define SIM_VEHICLE_H
+
+#include <cstdint>
+#include <functional>
+#include <vector>
+#include <mavsdk/plugins/mavlink_passthrough/mavlink_passthrough.h>
+
+// Scripted motion of a simulated vehicle.
+struct SimTrack {
+    enum class Kind { Stationary, Line, Circle };
+
+    Kind kind = Kind::Stationary;
+    // Start point (Stationary, Line) or center (Circle).
+    double latitude_deg = 0;
+    double longitude_deg = 0;
+    float altitude_m = 0;
+    double speed_m_s = 0;
+    // Line: course over ground.
+    double heading_deg = 0;
+    // Circle: radius, driven clockwise.
+    double radius_m = 0;
+};
+
+struct SimState {
+    double latitude_deg;
+    double longitude_deg;
+    float altitude_m;
+    float north_m_s;
+    float east_m_s;
+    float heading_deg;
+};
+
+SimState sim_track_state(const SimTrack& track, double time_s);
+
+struct SimVehicleConfig {
+    uint8_t sysid = 1;
+    // MAV_TYPE reported in the heartbeat: ships also roll and pitch in a light swell.
+    bool ship = false;
+    SimTrack track;
+    double position_rate_hz = 10;
+    double attitude_rate_hz = 10;
+    double home_rate_hz = 1;
+};
+
+struct SimVehicleStats {
+    uint64_t messages_sent = 0;
+    uint64_t set_home_commands = 0;
+    uint64_t mission_uploads = 0;
+    uint64_t partial_writes = 0;
+    uint64_t mission_items_received = 0;
+};
+
+// One stand-in vehicle speaking the subset of MAVLink the follow logic uses: heartbeat,
+// GLOBAL_POSITION_INT, ATTITUDE and HOME_POSITION along a scripted track, command
+// acknowledgement for DO_SET_HOME, SET_MESSAGE_INTERVAL and REQUEST_MESSAGE, and the
+// mission protocol (upload, download, MISSION_WRITE_PARTIAL_LIST, clear). It has no
+// I/O of its own: messages come in through handle() and go out through the sink, and
+// tick() emits whatever telemetry is due.
+class SimVehicle {
+public:
+    using Sink = std::function<void(const mavlink_message_t& message)>;
+
+    SimVehicle(SimVehicleConfig config, Sink sink);
+
+    // `time_ns` is the simulation clock, starting at 0.
+    void tick(int64_t time_ns);
+    void handle(const mavlink_message_t& message, int64_t time_ns);
+
+    // Earliest time tick() has something to send.
+    int64_t next_due_ns() const;
+
+    uint8_t sysid() const { return _config.sysid; }
+    const SimVehicleStats& stats() const { return _stats; }
+
+private:
+    struct Stream {
+        int64_t interval_ns;
+        int64_t next_ns;
+    };
+
+    void handle_command(uint16_t command, const float params[7], int32_t x, int32_t y, bool is_int,
+                        const mavlink_message_t& message, int64_t time_ns);
+    void handle_mission(const mavlink_message_t& message, int64_t time_ns);
+    void send(const mavlink_message_t& message);
+    void send_ack(uint16_t command, uint8_t result, const mavlink_message_t& to);
+    void send_heartbeat();
+    void send_autopilot_version();
+    void send_position(int64_t time_ns);
+    void send_attitude(int64_t time_ns);
+    void send_home(int64_t time_ns);
+    void send_mission_ack(uint8_t target_sysid, uint8_t target_compid, uint8_t type, uint8_t mission_type);
+    void request_mission_item(int64_t time_ns);
+    bool set_interval(uint32_t message_id, double interval_us);
+
+    SimVehicleConfig _config;
+    Sink _sink;
+    SimVehicleStats _stats;
+
+    Stream _heartbeat;
+    Stream _position;
+    Stream _attitude;
+    Stream _home_stream;
+
+    double _home_latitude_deg;
+    double _home_longitude_deg;
+    float _home_altitude_m;
+
+    // Mission as last accepted, and the transfer being received (if any).
+    std::vector<mavlink_mission_item_int_t> _mission;
+    std::vector<mavlink_mission_item_int_t> _staged;
+    bool _receiving = false;
+    bool _partial = false;
+    uint16_t _next_seq = 0;
+    uint16_t _end_seq = 0;
+    uint8_t _partner_sysid = 0;
+    uint8_t _partner_compid = 0;
+    int64_t _last_request_ns = 0;
+    int _request_retries = 0;
+};
+
+#endif // SIM_VEHICLE_H
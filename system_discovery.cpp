@@ -0,0 +1,85 @@
+#include "system_discovery.h"
+#include "telemetry_slot.h"
+#include <algorithm>
+#include <condition_variable>
+#include <mutex>
+#include <utility>
+
+namespace {
+
+const std::chrono::milliseconds COMPONENT_RECHECK(20);
+
+// Shared with the MAVSDK callbacks, which may still fire after discover_systems returns.
+struct DiscoveryEvents {
+    std::mutex mutex;
+    std::condition_variable cv;
+    uint64_t count = 0;
+};
+
+void notify(DiscoveryEvents& events) {
+    {
+        std::lock_guard<std::mutex> lock(events.mutex);
+        ++events.count;
+    }
+    events.cv.notify_all();
+}
+
+bool has_component(const mavsdk::System& system, uint8_t compid) {
+    const auto ids = system.component_ids();
+    return std::find(ids.begin(), ids.end(), compid) != ids.end();
+}
+
+} // namespace
+
+DiscoveryResult discover_systems(mavsdk::Mavsdk& mavsdk, const std::set<uint8_t>& required,
+                                 std::chrono::milliseconds timeout, uint8_t compid) {
+    using Clock = std::chrono::steady_clock;
+    const Clock::time_point deadline = Clock::now() + timeout;
+    auto events = std::make_shared<DiscoveryEvents>();
+    const auto new_system_handle = mavsdk.subscribe_on_new_system([events]() { notify(*events); });
+    std::vector<std::pair<std::shared_ptr<mavsdk::System>, mavsdk::System::IsConnectedHandle>> watched;
+
+    DiscoveryResult result;
+    uint64_t seen = 0;
+    while (result.systems.size() < required.size()) {
+        // Systems are scanned outside the callbacks, which only count events; subscribing
+        // from inside a MAVSDK callback is not safe.
+        bool incomplete = false;
+        for (const auto& system : mavsdk.systems()) {
+            const uint8_t sysid = system->get_system_id();
+            if (!required.count(sysid) || result.systems.count(sysid)) {
+                continue;
+            }
+            const bool known = std::any_of(watched.begin(), watched.end(),
+                                           [&system](const auto& entry) { return entry.first == system; });
+            if (!known) {
+                watched.emplace_back(system, system->subscribe_is_connected([events](bool) { notify(*events); }));
+            }
+            if (system->is_connected() && has_component(*system, compid)) {
+                result.systems[sysid] = system;
+                result.found_ns[sysid] = monotonic_ns();
+            } else {
+                incomplete = true;
+            }
+        }
+        if (result.systems.size() == required.size() || Clock::now() >= deadline) {
+            break;
+        }
+
+        std::unique_lock<std::mutex> lock(events->mutex);
+        const Clock::time_point wake = incomplete ? std::min(deadline, Clock::now() + COMPONENT_RECHECK) : deadline;
+        events->cv.wait_until(lock, wake, [&]() { return events->count != seen; });
+        seen = events->count;
+    }
+
+    mavsdk.unsubscribe_on_new_system(new_system_handle);
+    for (auto& entry : watched) {
+        entry.first->unsubscribe_is_connected(entry.second);
+    }
+    for (uint8_t sysid : required) {
+        if (!result.systems.count(sysid)) {
+            result.missing.push_back(sysid);
+        }
+    }
+    return result;
+}
@@ -0,0 +1,30 @@
+#ifndef SYSTEM_DISCOVERY_H
+#define SYSTEM_DISCOVERY_H
+
+#include <mavsdk/mavsdk.h>
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <set>
+#include <vector>
+
+struct DiscoveryResult {
+    std::map<uint8_t, std::shared_ptr<mavsdk::System>> systems;
+    // Monotonic time each system became usable.
+    std::map<uint8_t, int64_t> found_ns;
+    // Required sysids that were not usable before the timeout.
+    std::vector<uint8_t> missing;
+};
+
+// Waits until every sysid in `required` is connected and has sent a heartbeat from
+// component `compid` (MAV_COMP_ID_AUTOPILOT1 by default), or until `timeout`. Vehicles
+// are matched by sysid, never by the order MAVSDK happened to see them in. Returns as
+// soon as the last one appears: the wait is woken by subscribe_on_new_system and each
+// system's connection state rather than by polling. A system whose autopilot heartbeat
+// has not arrived yet raises no further event, so it alone is re-checked every few
+// milliseconds.
+DiscoveryResult discover_systems(mavsdk::Mavsdk& mavsdk, const std::set<uint8_t>& required,
+                                 std::chrono::milliseconds timeout, uint8_t compid = 1);
+
+#endif // SYSTEM_DISCOVERY_H
@@ -2,10 +2,16 @@
 #include <mavsdk/plugins/action/action.h>
 #include <mavsdk/plugins/telemetry/telemetry.h>
 #include <mavsdk/plugins/mission_raw/mission_raw.h>
+#include <mavsdk/plugins/mavlink_passthrough/mavlink_passthrough.h>
+#include <atomic>
 #include <iostream>
+#include <future>
 #include <thread>
 #include <chrono>
+#include <cmath>
 #include "coordinates.h"
+#include "mission_pipeline.h"
+#include "mission_sync.h"
 
 using namespace mavsdk;
 using namespace std::this_thread;
@@ -23,7 +29,8 @@ std::shared_ptr<System> connect_to_pixhawk(const std::string& connection_string)
     }
 
     std::shared_ptr<System> system;
-    bool connected = false;
+    // Written on MAVSDK's callback thread; `system` is published by the store to `connected`.
+    std::atomic<bool> connected{false};
     mavsdk->subscribe_on_new_system([&mavsdk, &system, &connected]() {
         const auto systems = mavsdk->systems();
         if (!systems.empty()) {
@@ -61,54 +68,39 @@ std::pair<double, double> set_home_position(std::shared_ptr<Telemetry> telemetry
     return {lat, lon};
 }
 
-void clear_mission(std::shared_ptr<MissionRaw> mission_raw) {
-    mission_raw->clear_mission();
-    std::cout << "Mission cleared" << std::endl;
-}
-
-std::vector<MissionRaw::MissionItem> get_current_mission(std::shared_ptr<MissionRaw> mission_raw) {
-    auto mission_pair = mission_raw->download_mission();
-    auto mission_items = mission_pair.second;
-    std::cout << "Mission count received: " << mission_items.size() << std::endl;
-    return mission_items;
-}
-
 std::pair<double, double> get_home_position(std::shared_ptr<Telemetry> telemetry) {
     auto home = telemetry->home();
     return {home.latitude_deg, home.longitude_deg};
 }
 
-void upload_mission(std::shared_ptr<MissionRaw> mission_raw, const std::vector<MissionRaw::MissionItem>& mission_items) {
-    mission_raw->upload_mission(mission_items);
-    std::cout << "Mission uploaded successfully" << std::endl;
-}
-
-void update_waypoints(std::shared_ptr<Telemetry> telemetry, std::shared_ptr<MissionRaw> mission_raw, const std::vector<double>& new_point, double threshold) {
-    auto waypoints = get_current_mission(mission_raw);
-    auto home = get_home_position(telemetry);
-    std::vector<std::pair<double, double>> waypoints_coords;
-    for (const auto& wp : waypoints) {
-        waypoints_coords.push_back({wp.x / 1e7, wp.y / 1e7});
+// Home is NaN (or 0, 0) until the vehicle has reported it, which can take a while after connecting.
+bool wait_for_home(std::shared_ptr<Telemetry> telemetry) {
+    std::cout << "Waiting for home position..." << std::endl;
+    for (int i = 0; i < 30; ++i) {
+        const auto home = get_home_position(telemetry);
+        if (std::isfinite(home.first) && std::isfinite(home.second) && (home.first != 0 || home.second != 0)) {
+            return true;
+        }
+        sleep_for(seconds(1));
     }
+    std::cerr << "Home position timeout" << std::endl;
+    return false;
+}
 
-    double bearing = calculate_bearing(new_point, {home.first, home.second});
-    double distance = haversine_distance({home.first, home.second}, new_point);
+// Moves the mission from the home it was planned around to the ship. The pipeline places
+// and sends it in the background (only the waypoints that changed since the last
+// acknowledged upload), so this never waits for the vehicle.
+void update_waypoints(MissionPipeline& mission_pipeline, const ShipPose& mission_home, const std::vector<double>& new_point, double threshold) {
+    double bearing = calculate_bearing(new_point, {mission_home.latitude_deg, mission_home.longitude_deg});
+    double distance = haversine_distance({mission_home.latitude_deg, mission_home.longitude_deg}, new_point);
     double distance_meters = distance * 1000;
 
     std::cout << distance << ", " << bearing << std::endl;
 
     if (distance_meters >= threshold) {
-        for (size_t i = 0; i < waypoints_coords.size(); ++i) {
-            auto point = waypoints_coords[i];
-            auto new_coords = translate_coordinates({point.first, point.second}, bearing, distance);
-            waypoints[i].x = static_cast<int32_t>(new_coords[0] * 1e7);
-            waypoints[i].y = static_cast<int32_t>(new_coords[1] * 1e7);
-            std::cout << "Updated waypoint " << i << " to new coordinates: " << waypoints[i].x << ", " << waypoints[i].y << std::endl;
-        }
+        // Same heading as the origin: the mission is translated, not rotated.
+        mission_pipeline.submit({new_point[0], new_point[1], mission_home.heading_deg});
     }
-
-    sleep_for(seconds(1));
-    upload_mission(mission_raw, waypoints);
 }
 
 int main() {
@@ -128,13 +120,53 @@ int main() {
     auto telemetry_drone = std::make_shared<Telemetry>(drone);
     auto telemetry_ship = std::make_shared<Telemetry>(ship);
     auto mission_raw = std::make_shared<MissionRaw>(drone);
+    auto mavlink_passthrough = std::make_shared<MavlinkPassthrough>(drone);
+
+    // Mission is downloaded once; from here on the local cache is the source of truth.
+    MavsdkMissionLink mission_link(*mission_raw, *mavlink_passthrough);
+    MissionSync mission_sync(mission_link);
+    WorkerPool mission_workers(1);
+    MissionPipeline mission_pipeline(mission_sync, mission_workers,
+                                     [&mission_sync](const ShipPose&, MissionTransferResult result, std::size_t, int64_t) {
+                                         if (result == MissionTransferResult::Failed) {
+                                             std::cerr << "Mission sync failed" << std::endl;
+                                             return;
+                                         }
+                                         if (result == MissionTransferResult::Cancelled) {
+                                             return;
+                                         }
+                                         // Runs on the transfer thread, the only one touching the sync's stats.
+                                         const auto& stats = mission_sync.stats();
+                                         std::cout << "Mission synced: " << stats.items_sent << " items sent, "
+                                                   << stats.partial_writes << " partial writes, "
+                                                   << stats.full_uploads << " full uploads" << std::endl;
+                                     });
+
+    // The mission is captured against home, so it must be known first.
+    if (!wait_for_home(telemetry_drone)) {
+        return 1;
+    }
+    auto home = get_home_position(telemetry_drone);
+    const ShipPose mission_home{home.first, home.second, 0};
+
+    std::promise<bool> loaded;
+    mission_pipeline.load(mission_home, [&loaded](bool success, std::size_t items) {
+        if (success) {
+            std::cout << "Mission count received: " << items << std::endl;
+        }
+        loaded.set_value(success);
+    });
+    if (!loaded.get_future().get()) {
+        std::cerr << "Mission download failed" << std::endl;
+        return 1;
+    }
 
     while (true) {
         auto ship_coords = get_gps_position(telemetry_ship);
         std::vector<double> new_point = {ship_coords[0], ship_coords[1]};
         double threshold = 25;  // metre
 
-        update_waypoints(telemetry_drone, mission_raw, new_point, threshold);
+        update_waypoints(mission_pipeline, mission_home, new_point, threshold);
         set_home_position(telemetry_drone, ship_coords[0], ship_coords[1]);
         sleep_for(seconds(5));  // 10 saniye bekle, ardından waypoint güncellemesini tekrar dene
     }
@@ -4,13 +4,31 @@
 #include <mavsdk/plugins/action/action.h>
 #include <mavsdk/plugins/telemetry/telemetry.h>
 #include <mavsdk/plugins/mission/mission.h>
+#include <mavsdk/plugins/mission_raw/mission_raw.h>
 #include <mavsdk/plugins/mavlink_passthrough/mavlink_passthrough.h>
 #include <iostream>
 #include <future>
+#include <atomic>
 #include <memory>
 #include <thread>
 #include <cmath> 
+#include <map>
+#include <set>
+#include <functional>
+#include <algorithm>
+#include <cstdlib>
 #include "coordinates.h"
+#include "fleet.h"
+#include "flight_recorder.h"
+#include "follow_logic.h"
+#include "home_command_channel.h"
+#include "latency_tracker.h"
+#include "mission_pipeline.h"
+#include "rate_controller.h"
+#include "ship_estimator.h"
+#include "system_discovery.h"
+#include "target_fusion.h"
+#include "telemetry_slot.h"
 
 using namespace mavsdk;
 using namespace std;
@@ -20,15 +38,43 @@ using chrono::seconds;
 using this_thread::sleep_for;
 
 // Home pozisyonu ayarlamak için gerekli değişkenler
-float home_latitude = 47.3977419;
-float home_longitude = 8.2455938;
+// Enlem/boylam float'ta ~0.5 m'ye yuvarlanır, bu yüzden double
+double home_latitude = 47.3977419;
+double home_longitude = 8.2455938;
 float home_altitude = 0;
-float drone2_pos[2];
-float drone2_attitude[3];
 float distance_treshold = 10;
-float distance_diff = 0;
-float drone1_homepos[2];
-float bearring = 0;
+double distance_diff = 0;
+double bearring = 0;
+
+// Geminin (sysid 2) telemetrisini ikinci kez taşıyan bağlantılar: --ship-link udp://:14560
+vector<string> ship_backup_links;
+
+// Telemetri callback'lerinin yazdığı, ana döngünün kilitsiz okuduğu son örnekler.
+// Gemi konumu bağlantı başına bir kaynak; en taze olanı seçilir, duran bağlantı düşer.
+// Kaynak sayısı argümanlar okunduktan sonra belli olur, main içinde oluşturulur
+unique_ptr<TargetFusion> drone2_pos;
+SourceTimeFilter drone2_logged_fixes;
+TelemetrySlot<AttitudeSample> drone2_attitude;
+TelemetrySlot<PositionSample> drone1_homepos;
+SampleSignal telemetry_signal;
+
+// Callback'ler cout yerine buraya ikili kayıt yazar (bloklamaz)
+FlightRecorder flight_recorder;
+
+// Geminin hızı ve eşiğe kalan mesafe; gemi telemetri hızını ayarlayan döngü okur.
+// Bağlantı bütçesi (B/s) --link-budget ile verilir, verilmezse bağlantı sınırlamaz
+atomic<double> ship_speed(-1);
+atomic<double> ship_margin(0);
+RateControllerConfig ship_rate;
+
+// İki home güncellemesi arasındaki en kısa süre
+chrono::milliseconds min_update_interval(200);
+
+// Eşik etrafında gidip gelmeyi önleyen histerezis
+FollowGate follow_gate(distance_treshold);
+
+// Gerekli sistemlerin hepsi bu süre içinde görünmezse başlatma başarısız
+chrono::milliseconds discovery_timeout(10000);
 
 double normalizeAngle(double angle) {
     // 360 dereceye göre mod alarak normalize et
@@ -45,28 +91,596 @@ double normalizeAngle(double angle) {
 float radian_to_degree(float radian) {
     return radian * (180.0 / M_PI);
 }
-//home noktası güncelleme fonksiyonu
-void update_home(MavlinkPassthrough& mavlink_passthrough, float home_latitude, float home_longitude, float home_altitude) {
-    MavlinkPassthrough::CommandLong command{};
-    command.target_sysid = mavlink_passthrough.get_target_sysid();
-    command.target_compid = mavlink_passthrough.get_target_compid();
+//home noktası güncelleme fonksiyonu, komutun gönderildiği anı döndürür.
+// send_command_long ACK'i bekleyip kendi tekrarlarını yapar; tekrarları HomeCommandChannel
+// yönettiği için komut doğrudan kuyruğa verilir. COMMAND_LONG parametreleri float olduğundan
+// konum 1e-7 derece çözünürlüklü COMMAND_INT ile gönderilir.
+int64_t update_home(MavlinkPassthrough& mavlink_passthrough, double home_latitude, double home_longitude, float home_altitude)
+{
+    mavlink_command_int_t command{};
+    command.target_system = mavlink_passthrough.get_target_sysid();
+    command.target_component = mavlink_passthrough.get_target_compid();
     command.command = MAV_CMD_DO_SET_HOME;
+    command.frame = MAV_FRAME_GLOBAL;
     command.param1 = 0; // Use specified location
-    command.param2 = 0; // Unused
-    command.param3 = 0; // Unused
-    command.param4 = 0; // Unused
-    command.param5 = home_latitude;
-    command.param6 = home_longitude;
-    command.param7 = home_altitude;
-
-    mavlink_passthrough.send_command_long(command);
+    command.x = static_cast<int32_t>(lround(home_latitude * 1e7));
+    command.y = static_cast<int32_t>(lround(home_longitude * 1e7));
+    command.z = home_altitude;
+
+    mavlink_passthrough.queue_message([command](MavlinkPassthrough::MavlinkAddress address, uint8_t channel)
+                                      {
+                                          mavlink_message_t message;
+                                          mavlink_msg_command_int_encode_chan(address.system_id, address.component_id,
+                                                                              channel, &message, &command);
+                                          return message;
+                                      });
+    const int64_t sent_ns = monotonic_ns();
 
     //cout << "Home noktası güncellendi.\n";
+    return sent_ns;
+}
+
+// DO_SET_HOME onaylarını (COMMAND_ACK) aracın komut kanalına ilet
+void subscribe_home_ack(MavlinkPassthrough& mavlink_passthrough, uint8_t sysid, HomeCommandChannel& home_channel)
+{
+    mavlink_passthrough.subscribe_message(MAVLINK_MSG_ID_COMMAND_ACK, [&home_channel, sysid](const mavlink_message_t& message)
+                                          {
+                                              mavlink_command_ack_t ack;
+                                              mavlink_msg_command_ack_decode(&message, &ack);
+                                              if (message.sysid != sysid || ack.command != MAV_CMD_DO_SET_HOME)
+                                              {
+                                                  return;
+                                              }
+                                              home_channel.on_ack(ack.result, monotonic_ns());
+                                          });
+}
+
+// Bir aracın bağlantı eklentileri
+struct VehiclePlugins
+{
+    unique_ptr<Telemetry> telemetry;
+    unique_ptr<MavlinkPassthrough> mavlink_passthrough;
+};
+
+// Eklentiler işçi havuzunda araçlar arasında paralel oluşturulur; set_rate_position
+// asenkron çağrıldığı için ACK beklemeleri bağlantı bağlantı sıralanmaz, üst üste biner
+bool bring_up_vehicles(const map<uint8_t, shared_ptr<System>>& systems, double rate_hz, size_t workers,
+                       map<uint8_t, VehiclePlugins>& plugins)
+{
+    vector<promise<Telemetry::Result>> rate_results(systems.size());
+    vector<future<Telemetry::Result>> rate_futures;
+    for (auto& result : rate_results)
+    {
+        rate_futures.push_back(result.get_future());
+    }
+    for (auto& entry : systems)
+    {
+        plugins[entry.first];
+    }
+
+    WorkerPool bring_up(min(workers, systems.size()));
+    size_t i = 0;
+    for (auto& entry : systems)
+    {
+        VehiclePlugins* vehicle = &plugins.at(entry.first);
+        promise<Telemetry::Result>* rate_result = &rate_results[i++];
+        shared_ptr<System> system = entry.second;
+        bring_up.post([vehicle, rate_result, system, rate_hz]()
+                      {
+                          vehicle->telemetry = make_unique<Telemetry>(system);
+                          vehicle->mavlink_passthrough = make_unique<MavlinkPassthrough>(system);
+                          vehicle->telemetry->set_rate_position_async(rate_hz, [rate_result](Telemetry::Result result)
+                                                                      {
+                                                                          rate_result->set_value(result);
+                                                                      });
+                      });
+    }
+
+    bool ok = true;
+    i = 0;
+    for (auto& entry : systems)
+    {
+        const Telemetry::Result result = rate_futures[i++].get();
+        if (result != Telemetry::Result::Success)
+        {
+            cerr << "Oran ayarlama başarısız (sysid " << int(entry.first) << "): " << result << '\n';
+            ok = false;
+        }
+    }
+    return ok;
+}
+
+// Eksik sistemleri yazdır; hepsi bulunduysa true
+bool report_discovery(const DiscoveryResult& discovery)
+{
+    if (discovery.missing.empty())
+    {
+        return true;
+    }
+    cerr << "Bulunamayan sistemler:";
+    for (uint8_t sysid : discovery.missing)
+    {
+        cerr << ' ' << int(sysid);
+    }
+    cerr << '\n';
+    return false;
+}
+
+// Gemi konumu Telemetry yerine ham GLOBAL_POSITION_INT'ten okunur: time_boot_ms, aynı
+// örneğin farklı bağlantılardan gelen kopyalarını sıralamak için gerekli
+void subscribe_ship_position(MavlinkPassthrough& mavlink_passthrough, uint8_t sysid,
+                             function<void(const TargetSample&)> callback)
+{
+    mavlink_passthrough.subscribe_message(MAVLINK_MSG_ID_GLOBAL_POSITION_INT, [sysid, callback](const mavlink_message_t& message)
+                                          {
+                                              const int64_t receipt_ns = monotonic_ns();
+                                              if (message.sysid != sysid)
+                                              {
+                                                  return;
+                                              }
+                                              mavlink_global_position_int_t position;
+                                              mavlink_msg_global_position_int_decode(&message, &position);
+                                              callback({{position.lat * 1e-7, position.lon * 1e-7,
+                                                         position.relative_alt * 1e-3f, receipt_ns},
+                                                        position.time_boot_ms});
+                                          });
+}
+
+// Gemi telemetrisini ikinci kez taşıyan yedek bağlantı. Kendi Mavsdk örneği olduğundan
+// gemi burada ayrı bir System olarak görünür ve ayrı bir konum kaynağı olur
+struct ShipLink
+{
+    string url;
+    unique_ptr<Mavsdk> mavsdk;
+    map<uint8_t, VehiclePlugins> plugins;
+};
+
+// Bulunamayan gemiler yalnızca uyarıdır; asıl bağlantı yine çalışır
+bool open_ship_link(ShipLink& link, const set<uint8_t>& ships, double rate_hz)
+{
+    link.mavsdk = make_unique<Mavsdk>(Mavsdk::Configuration{Mavsdk::ComponentType::GroundStation});
+    ConnectionResult connection_result = link.mavsdk->add_any_connection(link.url);
+    if (connection_result != ConnectionResult::Success)
+    {
+        cerr << "Yedek bağlantı başarısız (" << link.url << "): " << connection_result << '\n';
+        return false;
+    }
+    const DiscoveryResult discovery = discover_systems(*link.mavsdk, ships, discovery_timeout);
+    if (!discovery.missing.empty())
+    {
+        cerr << "Yedek bağlantıda (" << link.url << ") ";
+        report_discovery(discovery);
+    }
+    return bring_up_vehicles(discovery.systems, rate_hz, discovery.systems.size(), link.plugins);
+}
+
+// İki monotonik an arasındaki süre (ms)
+double elapsed_ms(int64_t since_ns, int64_t now_ns)
+{
+    return (now_ns - since_ns) / 1e6;
+}
+
+// Bağlantıdan gelen her MAVLink mesajının baytlarını sysid başına sayar. Intercept Mavsdk
+// örneği başına tektir; herhangi bir aracın passthrough'u ile bir kez kurulması yeter
+void meter_link(MavlinkPassthrough& mavlink_passthrough, LinkMeter& meter)
+{
+    mavlink_passthrough.intercept_incoming_messages_async([&meter](mavlink_message_t& message)
+                                                          {
+                                                              // MAVLink 1: 6 bayt başlık + 2 bayt CRC; MAVLink 2: 10 + 2, imzalıysa +13
+                                                              size_t bytes = message.len;
+                                                              if (message.magic == MAVLINK_STX_MAVLINK1)
+                                                              {
+                                                                  bytes += 8;
+                                                              }
+                                                              else
+                                                              {
+                                                                  bytes += MAVLINK_NUM_NON_PAYLOAD_BYTES;
+                                                                  if (message.incompat_flags & MAVLINK_IFLAG_SIGNED)
+                                                                  {
+                                                                      bytes += MAVLINK_SIGNATURE_BLOCK_LEN;
+                                                                  }
+                                                              }
+                                                              meter.on_message(message.sysid, bytes,
+                                                                               message.msgid == MAVLINK_MSG_ID_GLOBAL_POSITION_INT);
+                                                              return true;
+                                                          });
 }
 
+// Konum ve duruş hızı birlikte istenir; ACK beklenmez, ret yalnızca yazdırılır
+bool request_rates(Telemetry& telemetry, uint8_t sysid, double rate_hz)
+{
+    auto report = [sysid](Telemetry::Result result)
+    {
+        if (result != Telemetry::Result::Success)
+        {
+            cerr << "Oran ayarlama başarısız (sysid " << int(sysid) << "): " << result << '\n';
+        }
+    };
+    telemetry.set_rate_position_async(rate_hz, report);
+    telemetry.set_rate_attitude_euler_async(rate_hz, report);
+    return true;
+}
+
+// Oran değişimi kayda ve ekrana
+void log_rate_change(const RateChange& change)
+{
+    flight_recorder.record(make_rate_record(change.sysid, change.time_ns, change.from_hz, change.to_hz,
+                                            change.inputs.speed_m_s, change.inputs.margin_m,
+                                            change.inputs.link_bytes_s));
+    cout << "Oran sysid " << int(change.sysid) << ": " << change.from_hz << " -> " << change.to_hz << " Hz ("
+         << rate_reason_name(change.reason) << ", hız " << change.inputs.speed_m_s << " m/s, eşiğe "
+         << change.inputs.margin_m << " m, bağlantı " << change.inputs.link_bytes_s << " B/s)\n";
+}
+
+// Değişimden önceki ve sonraki dönem: araçtan gelen bayt/s, konum örnek aralığı, toplam gecikme p50
+void log_rate_effect(const RateEffect& effect)
+{
+    auto p50 = [](const LatencySummary& summary)
+    {
+        return summary.count ? to_string(summary.p50_ms) : string("-");
+    };
+    cout << "Oran etkisi sysid " << int(effect.sysid) << " (" << effect.from_hz << " -> " << effect.to_hz
+         << " Hz): " << effect.bytes_s_before << " -> " << effect.bytes_s_after << " B/s, konum aralığı "
+         << effect.interval_ms_before << " -> " << effect.interval_ms_after << " ms, gecikme p50 "
+         << p50(effect.latency_before) << " -> " << p50(effect.latency_after) << " ms\n";
+}
+
+// Gemiyi takip eden çiftler arasında en yüksek hız ve eşiğe en yakın mesafe
+bool ship_motion(const FleetFollower& follower, const vector<size_t>& pairs, RateInputs& inputs)
+{
+    bool found = false;
+    for (size_t pair : pairs)
+    {
+        double speed_m_s;
+        double margin_m;
+        if (!follower.motion(pair, speed_m_s, margin_m))
+        {
+            continue;
+        }
+        inputs.speed_m_s = found ? max(inputs.speed_m_s, speed_m_s) : speed_m_s;
+        inputs.margin_m = found ? min(inputs.margin_m, margin_m) : margin_m;
+        found = true;
+    }
+    return found;
+}
+
+
+// Filo modu: konfigürasyon dosyasındaki her drone/gemi çiftinin home noktasını takip et
+int run_fleet(const string& config_path, int64_t start_ns)
+{
+    FleetConfig config;
+    string error;
+    if (!load_fleet_config(config_path, config, error))
+    {
+        cerr << "Konfigürasyon okunamadı: " << error << '\n';
+        return 1;
+    }
+
+    Mavsdk mavsdk{Mavsdk::Configuration{Mavsdk::ComponentType::GroundStation}};
+    for (const auto& url : config.connections)
+    {
+        ConnectionResult connection_result = mavsdk.add_any_connection(url);
+        if (connection_result != ConnectionResult::Success)
+        {
+            cerr << "Bağlantı başarısız (" << url << "): " << connection_result << '\n';
+            return 1;
+        }
+    }
+
+    // Araçlar sırayla değil sysid ile eşleştirilir
+    set<uint8_t> required;
+    for (const auto& pair : config.pairs)
+    {
+        required.insert(pair.drone_sysid);
+        required.insert(pair.ship_sysid);
+    }
+    // Yedek gemi bağlantıları asıl keşifle paralel açılır, hazır olmayı geciktirmez
+    set<uint8_t> ships;
+    for (const auto& pair : config.pairs)
+    {
+        ships.insert(pair.ship_sysid);
+    }
+    vector<ShipLink> ship_links(config.ship_links.size());
+    vector<future<bool>> ship_links_ready;
+    for (size_t i = 0; i < ship_links.size(); ++i)
+    {
+        ship_links[i].url = config.ship_links[i];
+        ShipLink* link = &ship_links[i];
+        const double rate_hz = config.position_rate_hz;
+        ship_links_ready.push_back(async(launch::async, [link, &ships, rate_hz]() { return open_ship_link(*link, ships, rate_hz); }));
+    }
+
+    // Sabit bekleme yerine son gerekli sistem göründüğü anda devam edilir
+    const DiscoveryResult discovery = discover_systems(mavsdk, required, discovery_timeout);
+    if (!report_discovery(discovery))
+    {
+        return 1;
+    }
+    const int64_t discovered_ns = monotonic_ns();
+
+    // Her araç için eklentiler bir kez oluşturulur; bir gemiyi birden fazla çift paylaşabilir
+    struct Vehicle
+    {
+        unique_ptr<Telemetry> telemetry;
+        unique_ptr<MavlinkPassthrough> mavlink_passthrough;
+        unique_ptr<HomeCommandChannel> home_channel;
+        // Gemi konumu her bağlantıdan gelir ama kayda bir kez yazılır
+        SourceTimeFilter logged_fixes;
+        vector<size_t> ship_of;
+        vector<size_t> drone_of;
+    };
+    map<uint8_t, VehiclePlugins> plugins;
+    if (!bring_up_vehicles(discovery.systems, config.position_rate_hz, config.workers, plugins))
+    {
+        return 1;
+    }
+    map<uint8_t, Vehicle> vehicles;
+    for (auto& entry : plugins)
+    {
+        Vehicle& vehicle = vehicles[entry.first];
+        vehicle.telemetry = move(entry.second.telemetry);
+        vehicle.mavlink_passthrough = move(entry.second.mavlink_passthrough);
+    }
+    for (size_t i = 0; i < config.pairs.size(); ++i)
+    {
+        vehicles[config.pairs[i].ship_sysid].ship_of.push_back(i);
+        vehicles[config.pairs[i].drone_sysid].drone_of.push_back(i);
+    }
+
+    if (!flight_recorder.start(config.flight_log))
+    {
+        cerr << "Uçuş kaydı açılamadı: " << config.flight_log << '\n';
+        return 1;
+    }
+
+    // Gemi konumundan onaylanan home güncellemesine kadar aşama gecikmeleri
+    LatencyTracker latency(config.pairs.size());
+    vector<string> pair_names;
+    for (const auto& pair : config.pairs)
+    {
+        pair_names.push_back(pair.name);
+    }
+    LatencyExporter latency_exporter(latency, pair_names);
+    if (!latency_exporter.start(config.latency_export, config.latency_export_interval))
+    {
+        cerr << "Gecikme çıktısı açılamadı: " << config.latency_export << '\n';
+        return 1;
+    }
+
+    // Geodezi ve komut işleri araç başına thread yerine sabit bir işçi havuzunda çalışır
+    WorkerPool pool(config.workers);
+    FleetFollower* follower_ptr = nullptr;
+
+    // Her drone için tek bekleyen DO_SET_HOME; yenisi gelirse eskisinin yerini alır
+    for (auto& entry : vehicles)
+    {
+        const uint8_t sysid = entry.first;
+        Vehicle& vehicle = entry.second;
+        if (vehicle.drone_of.empty())
+        {
+            continue;
+        }
+        MavlinkPassthrough& passthrough = *vehicle.mavlink_passthrough;
+        vehicle.home_channel = make_unique<HomeCommandChannel>(
+            pool,
+            [&passthrough, &latency, sysid](size_t pair, const HomeCommand& command, int attempt)
+            {
+                const int64_t sent_ns = update_home(passthrough, command.latitude_deg, command.longitude_deg,
+                                                    command.altitude_m);
+                if (attempt == 0)
+                {
+                    latency.on_command_sent(pair, command.sample_time_ns, command.compute_start_ns,
+                                            command.compute_end_ns, sent_ns);
+                }
+                flight_recorder.record(make_home_command_record(pair, sysid, sent_ns, command.latitude_deg,
+                                                                command.longitude_deg, command.altitude_m,
+                                                                command.position_sigma_m));
+                return sent_ns;
+            },
+            [&latency, &follower_ptr](size_t pair, const HomeCommand&, HomeCommandResult result, int64_t time_ns)
+            {
+                if (result == HomeCommandResult::Accepted)
+                {
+                    latency.on_command_ack(pair, time_ns);
+                }
+                else if (result != HomeCommandResult::Superseded)
+                {
+                    follower_ptr->rearm(pair);
+                }
+            });
+        subscribe_home_ack(passthrough, sysid, *vehicle.home_channel);
+    }
+
+    FleetFollower follower(config.pairs, config.min_update_interval, pool,
+                           [&config, &vehicles](size_t pair, const HomeCommand& command)
+                           {
+                               vehicles.at(config.pairs[pair].drone_sysid).home_channel->submit(pair, command);
+                           },
+                           [](size_t pair, int64_t time_ns, const PositionSample& target,
+                              const FollowDecision& decision, double position_sigma_m)
+                           {
+                               flight_recorder.record(make_decision_record(pair, time_ns, target, decision, position_sigma_m));
+                           },
+                           1 + ship_links.size(), config.target_fusion);
+    follower_ptr = &follower;
+
+    // Kaynak 0 asıl bağlantı, 1.. yedek bağlantılar
+    auto subscribe_ship = [&follower, &vehicles](MavlinkPassthrough& passthrough, uint8_t sysid, size_t source)
+    {
+        Vehicle& vehicle = vehicles.at(sysid);
+        const vector<size_t> pairs = vehicle.ship_of;
+        SourceTimeFilter* logged_fixes = &vehicle.logged_fixes;
+        subscribe_ship_position(passthrough, sysid, [&follower, pairs, sysid, source, logged_fixes](const TargetSample& sample)
+                                {
+                                    if (logged_fixes->first(sample.source_time_ms))
+                                    {
+                                        flight_recorder.record(make_position_record(RecordType::Position, sysid, sample.position));
+                                    }
+                                    for (size_t pair : pairs)
+                                    {
+                                        follower.on_ship_position(pair, sample, source);
+                                    }
+                                });
+    };
+
+    for (auto& entry : vehicles)
+    {
+        const uint8_t sysid = entry.first;
+        Vehicle& vehicle = entry.second;
+        if (!vehicle.ship_of.empty())
+        {
+            const vector<size_t> pairs = vehicle.ship_of;
+            subscribe_ship(*vehicle.mavlink_passthrough, sysid, 0);
+            vehicle.telemetry->subscribe_attitude_euler([&follower, pairs, sysid](Telemetry::EulerAngle euler_angle)
+                                                       {
+                                                           const AttitudeSample sample{euler_angle.roll_deg, euler_angle.pitch_deg,
+                                                                                       float(normalizeAngle(euler_angle.yaw_deg)),
+                                                                                       monotonic_ns()};
+                                                           flight_recorder.record(make_attitude_record(sysid, sample));
+                                                           for (size_t pair : pairs)
+                                                           {
+                                                               follower.on_ship_attitude(pair, sample);
+                                                           }
+                                                       });
+        }
+        if (!vehicle.drone_of.empty())
+        {
+            const vector<size_t> pairs = vehicle.drone_of;
+            vehicle.telemetry->subscribe_home([&follower, pairs, sysid](Telemetry::Position home_position)
+                                             {
+                                                 const PositionSample sample{home_position.latitude_deg, home_position.longitude_deg,
+                                                                             home_position.relative_altitude_m, monotonic_ns()};
+                                                 flight_recorder.record(make_position_record(RecordType::Home, sysid, sample));
+                                                 for (size_t pair : pairs)
+                                                 {
+                                                     follower.on_drone_home(pair, sample);
+                                                 }
+                                             });
+        }
+    }
+    const int64_t ready_ns = monotonic_ns();
+    cout << "Filo hazır: " << follower.size() << " çift, " << pool.size() << " işçi; keşif "
+         << elapsed_ms(start_ns, discovered_ns) << " ms, hazır " << elapsed_ms(start_ns, ready_ns) << " ms\n";
+
+    for (size_t i = 0; i < ship_links.size(); ++i)
+    {
+        if (!ship_links_ready[i].get())
+        {
+            cerr << "Yedek bağlantı kullanılmıyor: " << ship_links[i].url << '\n';
+            continue;
+        }
+        for (auto& entry : ship_links[i].plugins)
+        {
+            subscribe_ship(*entry.second.mavlink_passthrough, entry.first, i + 1);
+        }
+        cout << "Yedek bağlantı hazır: " << ship_links[i].url << " (" << ship_links[i].plugins.size() << " gemi)\n";
+    }
+
+    // Gemi konum/duruş hızı geminin hızına, eşiğe kalan mesafeye ve bağlantı yüküne göre
+    // ayarlanır. Dronlar ve yedek bağlantılar position_rate_hz'de kalır
+    LinkMeter link_meter;
+    vector<unique_ptr<TelemetryRateLoop>> rate_loops;
+    WorkerPool rate_timers(1);
+    if (config.rate_control)
+    {
+        meter_link(*vehicles.begin()->second.mavlink_passthrough, link_meter);
+        for (auto& entry : vehicles)
+        {
+            if (entry.second.ship_of.empty())
+            {
+                continue;
+            }
+            const uint8_t sysid = entry.first;
+            const vector<size_t> pairs = entry.second.ship_of;
+            Telemetry* telemetry = entry.second.telemetry.get();
+            // Bağlantı bütçesi geminin kendi telsizine göre: rate_link grubu yoksa yalnız kendisi
+            RateControllerConfig rate = config.rate;
+            rate.link_floor_hz = config.position_rate_hz;
+            vector<uint8_t> link{sysid};
+            for (const auto& rate_link : config.rate_links)
+            {
+                if (find(rate_link.sysids.begin(), rate_link.sysids.end(), sysid) != rate_link.sysids.end())
+                {
+                    rate.link_budget_bytes_s = rate_link.budget_bytes_s;
+                    link = rate_link.sysids;
+                }
+            }
+            rate_loops.push_back(make_unique<TelemetryRateLoop>(
+                sysid, config.position_rate_hz, rate, link_meter, link, &latency, pairs,
+                [&follower, pairs](RateInputs& inputs) { return ship_motion(follower, pairs, inputs); },
+                [telemetry, sysid](double rate_hz) { return request_rates(*telemetry, sysid, rate_hz); },
+                log_rate_change, log_rate_effect));
+            rate_loops.back()->start(rate_timers);
+        }
+    }
+
+    while (true)
+    {
+        sleep_for(seconds(10));
+        uint64_t evaluations = 0;
+        uint64_t commands = 0;
+        uint64_t source_switches = 0;
+        for (size_t i = 0; i < follower.size(); ++i)
+        {
+            evaluations += follower.evaluations(i);
+            commands += follower.commands(i);
+            source_switches += follower.source_switches(i);
+        }
+        uint64_t rate_changes = 0;
+        for (const auto& loop : rate_loops)
+        {
+            rate_changes += loop->changes();
+        }
+        HomeChannelStats channel_stats;
+        for (auto& entry : vehicles)
+        {
+            if (entry.second.home_channel)
+            {
+                const HomeChannelStats stats = entry.second.home_channel->stats();
+                channel_stats.sent += stats.sent;
+                channel_stats.retries += stats.retries;
+                channel_stats.coalesced += stats.coalesced;
+                channel_stats.timed_out += stats.timed_out + stats.rejected;
+            }
+        }
+        cout << "Değerlendirme: " << evaluations << ", home komutu: " << commands
+             << " (gönderilen " << channel_stats.sent << ", tekrar " << channel_stats.retries
+             << ", birleşen " << channel_stats.coalesced << ", başarısız " << channel_stats.timed_out << ")"
+             << ", gemi kaynağı değişimi: " << source_switches << ", oran değişimi: " << rate_changes
+             << ", kayıt: " << flight_recorder.written() << " (düşen " << flight_recorder.dropped() << ")\n";
+    }
+
+    return 0;
+}
 
-int main()
+// Filo modu: takeoff_and_land <konfigürasyon>
+// İki araçlı mod: takeoff_and_land [--ship-link <url>]... [--link-budget <B/s>]
+int main(int argc, char** argv)
 {
+    // Hazır olma süresi programın başından ölçülür
+    const int64_t start_ns = monotonic_ns();
+    if (argc == 2 && argv[1][0] != '-')
+    {
+        return run_fleet(argv[1], start_ns);
+    }
+    for (int i = 1; i < argc; ++i)
+    {
+        const string arg = argv[i];
+        if (arg == "--ship-link" && i + 1 < argc)
+        {
+            ship_backup_links.push_back(argv[++i]);
+            continue;
+        }
+        if (arg == "--link-budget" && i + 1 < argc && atof(argv[i + 1]) > 0)
+        {
+            ship_rate.link_budget_bytes_s = atof(argv[++i]);
+            continue;
+        }
+        cerr << "Kullanım: " << argv[0] << " <filo.conf> | [--ship-link <url>]... [--link-budget <B/s>]\n";
+        return 1;
+    }
+    drone2_pos = make_unique<TargetFusion>(1 + ship_backup_links.size());
+
     Mavsdk mavsdk{Mavsdk::Configuration{Mavsdk::ComponentType::GroundStation}};
     ConnectionResult connection_result = mavsdk.add_any_connection("udp://:14540");           // bağlantı objesi
     ConnectionResult connection_result2 = mavsdk.add_any_connection("tcp://127.0.0.1:5772"); // bağlantı objesi
@@ -83,112 +697,272 @@ int main()
         return 1;
     }
 
-    // Wait until systems are found
-    this_thread::sleep_for(chrono::seconds(2));
+    // Araçlar keşif sırasıyla değil sysid ile eşleştirilir (PX4 SITL: örnek 0 -> 1, örnek 1 -> 2)
+    const uint8_t drone1_sysid = 1;
+    const uint8_t drone2_sysid = 2;
 
-    auto systems = mavsdk.systems();
+    // Yedek gemi bağlantıları asıl keşifle paralel açılır
+    vector<ShipLink> ship_links(ship_backup_links.size());
+    vector<future<bool>> ship_links_ready;
+    for (size_t i = 0; i < ship_links.size(); ++i)
+    {
+        ship_links[i].url = ship_backup_links[i];
+        ShipLink* link = &ship_links[i];
+        ship_links_ready.push_back(async(launch::async, [link, drone2_sysid]() { return open_ship_link(*link, {drone2_sysid}, 1.0); }));
+    }
 
-    if (systems.size() < 2) {
-        cerr << "Yeterli sayıda sistem bulunamadı.\n";
+    const DiscoveryResult discovery = discover_systems(mavsdk, {drone1_sysid, drone2_sysid}, discovery_timeout);
+    if (!report_discovery(discovery))
+    {
         return 1;
     }
+    const int64_t discovered_ns = monotonic_ns();
+    shared_ptr<System> system1 = discovery.systems.at(drone1_sysid);
+    shared_ptr<System> system2 = discovery.systems.at(drone2_sysid);
 
-    shared_ptr<System> system1 = systems.at(0);
-    shared_ptr<System> system2 = systems.at(1);
-
-    if (!system1->is_connected() || !system2->is_connected())
+    if (!flight_recorder.start("flight"))
     {
-        cerr << "Sistem bağlı değil\n";
+        cerr << "Uçuş kaydı açılamadı\n";
         return 1;
     }
-    cout << "Araçlar Hazır...\n";
 
-    //gerekli objeler
-    Telemetry telemetry1(system1);
-    Telemetry telemetry2(system2);
-    
-    Action action1(system1);
-    Action action2(system2);
-
-    Mission mission1(system1);
-    Mission mission2(system2);
-
-    MavlinkPassthrough mavlink_passthrough1(system1);
-    MavlinkPassthrough mavlink_passthrough2(system2);
-
-    
-    //telemetri rate ayarlama
-    auto set_rate_result1 = telemetry1.set_rate_position(1.0);
-    if (set_rate_result1 != Telemetry::Result::Success)
+    LatencyTracker latency(1);
+    LatencyExporter latency_exporter(latency, {"drone1"});
+    if (!latency_exporter.start("file:latency.jsonl", seconds(10)))
     {
-        cerr << "Oran ayarlama başarısız: " << set_rate_result1 << '\n';
+        cerr << "Gecikme çıktısı açılamadı\n";
         return 1;
     }
 
-    auto set_rate_result2 = telemetry2.set_rate_position(1.0);
-    if (set_rate_result2 != Telemetry::Result::Success)
+    //gerekli objeler, telemetri rate ayarlama ile birlikte iki araç için paralel
+    map<uint8_t, VehiclePlugins> plugins;
+    if (!bring_up_vehicles(discovery.systems, 1.0, 2, plugins))
     {
-        cerr << "Oran ayarlama başarısız: " << set_rate_result2 << '\n';
         return 1;
     }
+    Telemetry& telemetry1 = *plugins.at(drone1_sysid).telemetry;
+    Telemetry& telemetry2 = *plugins.at(drone2_sysid).telemetry;
+    MavlinkPassthrough& mavlink_passthrough1 = *plugins.at(drone1_sysid).mavlink_passthrough;
+
+    Action action1(system1);
+    Action action2(system2);
+
+    Mission mission1(system1);
+    Mission mission2(system2);
+
+    cout << "Araçlar Hazır... keşif " << elapsed_ms(start_ns, discovered_ns) << " ms, hazır "
+         << elapsed_ms(start_ns, monotonic_ns()) << " ms\n";
 
     // telemetry1.subscribe_position([](Telemetry::Position position)
     //                              { cout << "Drone 1 - Yükseklik: " << position.relative_altitude_m << " m, "
     //                                     << "Enlem: " << position.latitude_deg << " derece, "
     //                                     << "Boylam: " << position.longitude_deg << " derece" << endl; });
 
-    //hedef gemi için posizyon bilgisi yayını
-    telemetry2.subscribe_position([](Telemetry::Position position)
-                                 { cout << "Drone 2 - Yükseklik: " << position.relative_altitude_m << " m, "
-                                        << "Enlem: " << drone2_pos[0] << " derece, "
-                                        << "Boylam: " << drone2_pos[1] << " derece" << endl;
-                                        drone2_pos[0] = position.latitude_deg;
-                                        drone2_pos[1] = position.longitude_deg;
-                                        });
+    //hedef gemi için posizyon bilgisi yayını, bağlantı başına bir kaynak
+    auto publish_ship = [drone2_sysid](size_t source)
+    {
+        return [drone2_sysid, source](const TargetSample& sample)
+        {
+            if (!drone2_pos->publish(source, sample))
+            {
+                return;
+            }
+            telemetry_signal.notify();
+            if (drone2_logged_fixes.first(sample.source_time_ms))
+            {
+                flight_recorder.record(make_position_record(RecordType::Position, drone2_sysid, sample.position));
+            }
+        };
+    };
+    subscribe_ship_position(*plugins.at(drone2_sysid).mavlink_passthrough, drone2_sysid, publish_ship(0));
+    for (size_t i = 0; i < ship_links.size(); ++i)
+    {
+        if (!ship_links_ready[i].get() || !ship_links[i].plugins.count(drone2_sysid))
+        {
+            cerr << "Yedek bağlantı kullanılmıyor: " << ship_links[i].url << '\n';
+            continue;
+        }
+        subscribe_ship_position(*ship_links[i].plugins.at(drone2_sysid).mavlink_passthrough, drone2_sysid, publish_ship(i + 1));
+    }
 
     //hedef gemi için euler açıları bilgileri
-    telemetry2.subscribe_attitude_euler([](Telemetry::EulerAngle euler_angle)
+    telemetry2.subscribe_attitude_euler([drone2_sysid](Telemetry::EulerAngle euler_angle)
                                         {   
-                                            float roll_deg = radian_to_degree(euler_angle.roll_deg);
-                                            float pitch_deg = radian_to_degree(euler_angle.pitch_deg);
-                                            float yaw_deg = normalizeAngle(radian_to_degree(euler_angle.yaw_deg));
-                                            drone2_attitude[0] = roll_deg;
-                                            drone2_attitude[1] = pitch_deg;
-                                            drone2_attitude[2] = yaw_deg;
-                                            cout << "Drone 2 - Roll: " << drone2_attitude[0] << " derece, "
-                                                 << "Pitch: " << drone2_attitude[1] << " derece, "
-                                                 << "Yaw: " << drone2_attitude[2] << " derece" << endl;
+                                            // MAVSDK açıları zaten derece olarak verir
+                                            float roll_deg = euler_angle.roll_deg;
+                                            float pitch_deg = euler_angle.pitch_deg;
+                                            float yaw_deg = normalizeAngle(euler_angle.yaw_deg);
+                                            const AttitudeSample sample{roll_deg, pitch_deg, yaw_deg, monotonic_ns()};
+                                            drone2_attitude.publish(sample);
+                                            flight_recorder.record(make_attitude_record(drone2_sysid, sample));
                                         });
 
     // Drone 1 home pozisyonunu alma
-     telemetry1.subscribe_home([](Telemetry::Position home_position)
+     telemetry1.subscribe_home([drone1_sysid](Telemetry::Position home_position)
                               {
-                                  cout << "Drone 1 Home - Enlem: " << home_position.latitude_deg 
-                                  << ", Boylam: " << home_position.longitude_deg 
-                                  << ", Yükseklik: " << home_position.relative_altitude_m << " m" << endl;
-                                  drone1_homepos[0] = home_position.latitude_deg; 
-                                  drone1_homepos[1] = home_position.longitude_deg; 
+                                  const PositionSample sample{home_position.latitude_deg, home_position.longitude_deg,
+                                                              home_position.relative_altitude_m, monotonic_ns()};
+                                  drone1_homepos.publish(sample);
+                                  telemetry_signal.notify();
+                                  flight_recorder.record(make_position_record(RecordType::Home, drone1_sysid, sample));
                               });
 
+    // DO_SET_HOME zaman aşımı ve tekrar zamanlayıcıları
+    WorkerPool home_timers(1);
+    HomeCommandChannel home_channel(home_timers,
+                                    [&mavlink_passthrough1, &latency, drone1_sysid](size_t, const HomeCommand& command, int attempt)
+                                    {
+                                        const int64_t sent_ns = update_home(mavlink_passthrough1, command.latitude_deg,
+                                                                            command.longitude_deg, command.altitude_m);
+                                        if (attempt == 0)
+                                        {
+                                            latency.on_command_sent(0, command.sample_time_ns, command.compute_start_ns,
+                                                                    command.compute_end_ns, sent_ns);
+                                        }
+                                        flight_recorder.record(make_home_command_record(0, drone1_sysid, sent_ns, command.latitude_deg,
+                                                                                        command.longitude_deg, command.altitude_m,
+                                                                                        command.position_sigma_m));
+                                        return sent_ns;
+                                    },
+                                    [&latency](size_t, const HomeCommand&, HomeCommandResult result, int64_t time_ns)
+                                    {
+                                        if (result == HomeCommandResult::Accepted)
+                                        {
+                                            latency.on_command_ack(0, time_ns);
+                                        }
+                                        else if (result != HomeCommandResult::Superseded)
+                                        {
+                                            follow_gate.rearm();
+                                        }
+                                    });
+    subscribe_home_ack(mavlink_passthrough1, drone1_sysid, home_channel);
+
+    // Drone 1 görevi gemiyle birlikte taşınır. Görev indirme/yükleme ana döngüyü bloklamaz:
+    // sonraki görev mevcut yükleme sürerken hesaplanır, eskiyen yükleme iptal edilir
+    MissionRaw mission_raw1(system1);
+    MavsdkMissionLink mission_link(mission_raw1, mavlink_passthrough1);
+    MissionSync mission_sync(mission_link);
+    WorkerPool mission_workers(1);
+    MissionPipeline mission_pipeline(mission_sync, mission_workers);
+    bool mission_requested = false;
+
+    // Gemi telemetri hızı, geminin hareketine ve bağlantı yüküne göre; drone 1 Hz'de kalır
+    LinkMeter link_meter;
+    meter_link(mavlink_passthrough1, link_meter);
+    TelemetryRateLoop ship_rate_loop(drone2_sysid, 1.0, ship_rate, link_meter, {drone2_sysid}, &latency, {0},
+                                     [](RateInputs& inputs)
+                                     {
+                                         inputs.speed_m_s = ship_speed.load();
+                                         inputs.margin_m = ship_margin.load();
+                                         return inputs.speed_m_s >= 0;
+                                     },
+                                     [&telemetry2, drone2_sysid](double rate_hz) { return request_rates(telemetry2, drone2_sysid, rate_hz); },
+                                     log_rate_change, log_rate_effect);
+    WorkerPool rate_timers(1);
+    ship_rate_loop.start(rate_timers);
+
+
+    // Sabit bekleme yerine yeni telemetri örneği geldiğinde uyan
+    uint64_t seen_signal = 0;
+    uint64_t seen_pos = 0;
+    uint64_t seen_home = 0;
+    uint64_t seen_attitude = 0;
+    chrono::steady_clock::time_point last_update{};
+    // Kestirimciye verilen son konumun gemi zamanı; başka bağlantıdan gelen kopyası yeni değildir
+    bool have_fix = false;
+    uint32_t fix_time_ms = 0;
+
+    // Düşük telemetri hızında gemi konumunu komut gönderme anına taşır
+    ShipEstimator ship_estimator;
+    // Gemi pruvası; attitude gelene kadar görevin planlandığı yön (0) kabul edilir
+    double ship_heading = 0;
 
     while (true)
     {
-        sleep_for(seconds(1));
-
-        vector<double> drone2_pos_vector = {drone2_pos[0], drone2_pos[1]};
-        vector<double> drone1_homepos_vector = {drone1_homepos[0], drone1_homepos[1]};
+        seen_signal = telemetry_signal.wait_for(seen_signal, seconds(1));
+
+        // Bütün bağlantılar durduysa eski konumla home güncellenmez
+        FusedTarget fused{};
+        PositionSample home{};
+        uint64_t pos_version = drone2_pos->version();
+        uint64_t home_version = 0;
+        if (!drone2_pos->select(monotonic_ns(), fused) || !drone1_homepos.read(home, home_version)) {
+            continue;
+        }
+        if (pos_version == seen_pos && home_version == seen_home) {
+            continue;
+        }
 
-        distance_diff = haversine_distance(drone2_pos_vector,drone1_homepos_vector);
-        bearring = calculate_bearing(drone2_pos_vector,drone1_homepos_vector);
-        cout << distance_diff*1000 << " Meter" << endl;
-        cout << bearring << " degres" << endl;
-        
+        // En kısa güncelleme aralığı dolmadıysa bekle, sonra en taze örneği kullan
+        if (chrono::steady_clock::now() - last_update < min_update_interval) {
+            this_thread::sleep_until(last_update + min_update_interval);
+            pos_version = drone2_pos->version();
+            if (!drone2_pos->select(monotonic_ns(), fused)) {
+                continue;
+            }
+            drone1_homepos.read(home, home_version);
+        }
+        const int64_t compute_start_ns = monotonic_ns();
+        const PositionSample& ship = fused.position;
+        if (!have_fix || source_time_newer(fused.source_time_ms, fix_time_ms))
+        {
+            ship_estimator.update_position(ship);
+            have_fix = true;
+            fix_time_ms = fused.source_time_ms;
+        }
+        AttitudeSample attitude{};
+        uint64_t attitude_version = 0;
+        if (drone2_attitude.read(attitude, attitude_version) && attitude_version != seen_attitude)
+        {
+            ship_estimator.update_attitude(attitude);
+            seen_attitude = attitude_version;
+            ship_heading = attitude.yaw_deg;
+        }
+        seen_pos = pos_version;
+        seen_home = home_version;
+        last_update = chrono::steady_clock::now();
+
+        const int64_t now_ns = monotonic_ns();
+        ShipEstimate estimate = ship_estimator.predict(now_ns);
+        PositionSample target = ship;
+        target.latitude_deg = estimate.latitude_deg;
+        target.longitude_deg = estimate.longitude_deg;
+
+        FollowDecision decision = evaluate_follow(target, home, distance_treshold);
+        const int64_t compute_end_ns = monotonic_ns();
+        distance_diff = decision.distance_m / 1000;
+        bearring = decision.bearing_deg;
+        ship_margin = fabs(distance_treshold - decision.distance_m);
+        ship_speed = hypot(estimate.north_m_s, estimate.east_m_s);
+        flight_recorder.record(make_decision_record(0, now_ns, target, decision, estimate.position_sigma_m));
+
+        // Görev, drone 1'in home'u ve geminin o anki pruvası etrafında planlanmış sayılır
+        // ve bir kez indirilir (prototip ve flight_replay de home'u kullanır); gemiyle
+        // home arasındaki başlangıç farkı böylece göreve de uygulanır
+        const ShipPose pose{target.latitude_deg, target.longitude_deg, ship_heading};
+        if (!mission_requested)
+        {
+            mission_requested = true;
+            mission_pipeline.load({home.latitude_deg, home.longitude_deg, ship_heading}, [](bool success, size_t items)
+                                  {
+                                      if (!success)
+                                      {
+                                          cerr << "Görev indirilemedi, görev takibi kapalı\n";
+                                      }
+                                      else if (items == 0)
+                                      {
+                                          cout << "Araçta görev yok, görev takibi kapalı\n";
+                                      }
+                                  });
+        }
 
-        if (distance_diff*1000 >= distance_treshold){
+        if (follow_gate.update(decision, target)){
             
-            update_home(mavlink_passthrough1, drone2_pos[0], drone2_pos[1], home_altitude);
+            home_channel.submit(0, {target.latitude_deg, target.longitude_deg, home_altitude, ship.time_ns,
+                                    estimate.position_sigma_m, compute_start_ns, compute_end_ns});
+            mission_pipeline.submit(pose);
         }
     }
 
     return 0;
-}
\ No newline at end of file
+}
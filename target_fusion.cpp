@@ -0,0 +1,69 @@
+#include "target_fusion.h"
+#include <algorithm>
+#include <cmath>
+
+TargetFusion::TargetFusion(std::size_t sources, TargetFusionConfig config) :
+    _config(config)
+{
+    _sources.reserve(sources);
+    for (std::size_t i = 0; i < sources; ++i) {
+        _sources.emplace_back(new Source());
+    }
+}
+
+bool TargetFusion::publish(std::size_t source, const TargetSample& sample) {
+    const PositionSample& position = sample.position;
+    if (!std::isfinite(position.latitude_deg) || !std::isfinite(position.longitude_deg) ||
+        (position.latitude_deg == 0 && position.longitude_deg == 0)) {
+        return false;
+    }
+
+    Source& state = *_sources[source];
+    if (state.last_receipt_ns != 0 && position.time_ns > state.last_receipt_ns) {
+        const int64_t interval = position.time_ns - state.last_receipt_ns;
+        const int64_t smoothed = state.interval_ns.load(std::memory_order_relaxed);
+        state.interval_ns.store(smoothed ? (3 * smoothed + interval) / 4 : interval, std::memory_order_relaxed);
+    }
+    state.last_receipt_ns = position.time_ns;
+    state.slot.publish(sample);
+    _version.fetch_add(1, std::memory_order_release);
+    return true;
+}
+
+int64_t TargetFusion::stale_after_ns(const Source& source) const {
+    const int64_t max_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(_config.max_stale).count();
+    const int64_t interval = source.interval_ns.load(std::memory_order_relaxed);
+    if (interval == 0) {
+        return max_ns;
+    }
+    const int64_t min_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(_config.min_stale).count();
+    return std::min(max_ns, std::max(min_ns, static_cast<int64_t>(_config.stale_intervals * interval)));
+}
+
+bool TargetFusion::stale(std::size_t source, int64_t now_ns) const {
+    const Source& state = *_sources[source];
+    TargetSample sample;
+    return !state.slot.read(sample) || now_ns - sample.position.time_ns > stale_after_ns(state);
+}
+
+bool TargetFusion::select(int64_t now_ns, FusedTarget& out) const {
+    bool found = false;
+    std::size_t live = 0;
+    for (std::size_t i = 0; i < _sources.size(); ++i) {
+        const Source& state = *_sources[i];
+        TargetSample sample;
+        if (!state.slot.read(sample) || now_ns - sample.position.time_ns > stale_after_ns(state)) {
+            continue;
+        }
+        ++live;
+        if (!found || source_time_newer(sample.source_time_ms, out.source_time_ms) ||
+            (sample.source_time_ms == out.source_time_ms && sample.position.time_ns < out.position.time_ns)) {
+            out.position = sample.position;
+            out.source_time_ms = sample.source_time_ms;
+            out.source = i;
+            found = true;
+        }
+    }
+    out.live_sources = live;
+    return found;
+}
@@ -0,0 +1,101 @@
+#ifndef TARGET_FUSION_H
+#define TARGET_FUSION_H
+
+#include "telemetry_slot.h"
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+// A ship position as received on one link: the receipt stamp in `position.time_ns` plus
+// the vehicle's own GLOBAL_POSITION_INT time_boot_ms, which orders copies of the same
+// stream that arrive over different links.
+struct TargetSample {
+    PositionSample position;
+    uint32_t source_time_ms;
+};
+
+// time_boot_ms wraps after ~49 days; compare through the signed difference.
+inline bool source_time_newer(uint32_t a_ms, uint32_t b_ms) {
+    return static_cast<int32_t>(a_ms - b_ms) > 0;
+}
+
+struct TargetFusionConfig {
+    // A source is dropped once its newest sample is older than this many of its own
+    // average sample intervals, clamped to [min_stale, max_stale]. max_stale also applies
+    // until the interval is known.
+    double stale_intervals = 2.5;
+    std::chrono::milliseconds min_stale{50};
+    std::chrono::milliseconds max_stale{3000};
+};
+
+struct FusedTarget {
+    PositionSample position;
+    uint32_t source_time_ms;
+    std::size_t source;
+    // Sources that were fresh at the selection time.
+    std::size_t live_sources;
+};
+
+// One target fed by several redundant links. Every source has its own lock-free slot and
+// a single writer (that link's telemetry callback); select() picks the newest sample by
+// vehicle time among the sources that are still fresh by receipt time. Copies of one
+// sample arriving on several links resolve to the earliest receipt, so a lagging link
+// never looks fresher than the one that delivered first, and a stalled link stops being
+// considered as soon as its own sample rate says it is overdue.
+class TargetFusion {
+public:
+    explicit TargetFusion(std::size_t sources, TargetFusionConfig config = {});
+
+    // Returns false (and drops the sample) for non-finite or 0/0 coordinates, which a
+    // vehicle reports before its first fix.
+    bool publish(std::size_t source, const TargetSample& sample);
+
+    // The target position at `now_ns`. False if no source has a fresh sample.
+    bool select(int64_t now_ns, FusedTarget& out) const;
+
+    bool stale(std::size_t source, int64_t now_ns) const;
+
+    // Changes whenever any source publishes.
+    uint64_t version() const { return _version.load(std::memory_order_acquire); }
+    std::size_t size() const { return _sources.size(); }
+
+private:
+    struct Source {
+        TelemetrySlot<TargetSample> slot;
+        // Smoothed receipt interval; written by the source's writer only.
+        std::atomic<int64_t> interval_ns{0};
+        int64_t last_receipt_ns = 0;
+    };
+
+    int64_t stale_after_ns(const Source& source) const;
+
+    TargetFusionConfig _config;
+    std::vector<std::unique_ptr<Source>> _sources;
+    std::atomic<uint64_t> _version{0};
+};
+
+// Passes each vehicle time once: the first copy of a sample from any link returns true,
+// later or older copies false. Lets a consumer shared by all links (e.g. the flight log)
+// see one stream. Lock-free; any number of writers.
+class SourceTimeFilter {
+public:
+    bool first(uint32_t source_time_ms) {
+        uint64_t current = _newest.load(std::memory_order_relaxed);
+        const uint64_t next = HAVE | source_time_ms;
+        do {
+            if ((current & HAVE) && !source_time_newer(source_time_ms, static_cast<uint32_t>(current))) {
+                return false;
+            }
+        } while (!_newest.compare_exchange_weak(current, next, std::memory_order_relaxed));
+        return true;
+    }
+
+private:
+    static constexpr uint64_t HAVE = uint64_t(1) << 32;
+    std::atomic<uint64_t> _newest{0};
+};
+
+#endif // TARGET_FUSION_H
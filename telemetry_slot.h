@@ -0,0 +1,126 @@
+#ifndef TELEMETRY_SLOT_H
+#define TELEMETRY_SLOT_H
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstring>
+#include <mutex>
+#include <type_traits>
+
+// Latest-value slot for one telemetry stream: a seqlock with a single writer (the MAVSDK
+// callback) and any number of readers. Neither side ever blocks; a reader that races a
+// write simply retries. The payload is stored as relaxed atomic words so concurrent
+// reads and writes are well defined.
+template <typename T>
+class TelemetrySlot {
+    static_assert(std::is_trivially_copyable<T>::value, "TelemetrySlot needs a trivially copyable sample");
+
+public:
+    void publish(const T& value) {
+        std::array<uint64_t, WORDS> words{};
+        std::memcpy(words.data(), &value, sizeof(T));
+
+        const uint64_t seq = _seq.load(std::memory_order_relaxed);
+        _seq.store(seq + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        for (std::size_t i = 0; i < WORDS; ++i) {
+            _words[i].store(words[i], std::memory_order_relaxed);
+        }
+        _seq.store(seq + 2, std::memory_order_release);
+    }
+
+    // Copies the latest sample into `out`. Returns false if nothing was published yet.
+    bool read(T& out) const {
+        uint64_t version;
+        return read(out, version);
+    }
+
+    // Same as read(), also returning the version the sample belongs to.
+    bool read(T& out, uint64_t& version) const {
+        std::array<uint64_t, WORDS> words;
+        uint64_t before;
+        uint64_t after;
+        do {
+            before = _seq.load(std::memory_order_acquire);
+            while (before & 1) {
+                before = _seq.load(std::memory_order_acquire);
+            }
+            for (std::size_t i = 0; i < WORDS; ++i) {
+                words[i] = _words[i].load(std::memory_order_relaxed);
+            }
+            std::atomic_thread_fence(std::memory_order_acquire);
+            after = _seq.load(std::memory_order_relaxed);
+        } while (before != after);
+
+        version = before / 2;
+        if (version == 0) {
+            return false;
+        }
+        std::memcpy(&out, words.data(), sizeof(T));
+        return true;
+    }
+
+    // Number of samples published so far; changes whenever a new sample lands.
+    uint64_t version() const {
+        return _seq.load(std::memory_order_acquire) / 2;
+    }
+
+private:
+    static constexpr std::size_t WORDS = (sizeof(T) + sizeof(uint64_t) - 1) / sizeof(uint64_t);
+
+    std::atomic<uint64_t> _seq{0};
+    std::array<std::atomic<uint64_t>, WORDS> _words{};
+};
+
+// Wakes a consumer when one of the slots it watches gets a new sample. Writers call
+// notify() after publish(); the consumer blocks in wait_for() instead of sleeping a
+// fixed period.
+class SampleSignal {
+public:
+    void notify() {
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            ++_count;
+        }
+        _cv.notify_all();
+    }
+
+    // Waits until notify() was called since `seen` (or the timeout passed) and returns the new count.
+    template <typename Rep, typename Period>
+    uint64_t wait_for(uint64_t seen, const std::chrono::duration<Rep, Period>& timeout) {
+        std::unique_lock<std::mutex> lock(_mutex);
+        _cv.wait_for(lock, timeout, [&]() { return _count != seen; });
+        return _count;
+    }
+
+private:
+    std::mutex _mutex;
+    std::condition_variable _cv;
+    uint64_t _count = 0;
+};
+
+// Monotonic time in nanoseconds, used to stamp samples.
+inline int64_t monotonic_ns() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+}
+
+struct PositionSample {
+    double latitude_deg;
+    double longitude_deg;
+    float relative_altitude_m;
+    int64_t time_ns;
+};
+
+struct AttitudeSample {
+    float roll_deg;
+    float pitch_deg;
+    float yaw_deg;
+    int64_t time_ns;
+};
+
+#endif // TELEMETRY_SLOT_H
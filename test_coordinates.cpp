@@ -0,0 +1,167 @@
+// Checks the batch geodesy functions against the scalar ones within the tolerances
+// documented in coordinates.h. Sizes cover the AVX2 body (multiples of 4), the scalar
+// tail and empty input; points include the antimeridian and both poles.
+#include "coordinates.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+namespace {
+
+const double BEARING_TOLERANCE_DEG = 1e-8;
+const double COORDINATE_TOLERANCE_DEG = 1e-9;
+const double DISTANCE_TOLERANCE_KM = 1e-8;
+// Longitudes translated from within POLE_CAP_DEG of a pole.
+const double POLE_CAP_DEG = 1e-3;
+const double POLE_LONGITUDE_TOLERANCE_DEG = 1e-7;
+
+int failures = 0;
+
+// Angles that differ by a whole turn are the same direction / meridian.
+double angle_difference(double a, double b) {
+    const double d = std::fmod(std::fabs(a - b), 360.0);
+    return std::min(d, 360.0 - d);
+}
+
+void check(bool ok, const char* what, std::size_t n, std::size_t i, double batch, double scalar) {
+    if (!ok) {
+        ++failures;
+        if (failures <= 20) {
+            std::printf("FAIL %s n=%zu i=%zu: batch %.15g scalar %.15g (diff %.3g)\n", what, n, i, batch, scalar,
+                        batch - scalar);
+        }
+    }
+}
+
+struct Points {
+    std::vector<double> lat;
+    std::vector<double> lon;
+
+    void add(double latitude, double longitude) {
+        lat.push_back(latitude);
+        lon.push_back(longitude);
+    }
+    LatLonSpan span(std::size_t n) const { return {lat.data(), lon.data(), n}; }
+};
+
+void check_pairs(const Points& from, const Points& to, std::size_t n) {
+    std::vector<double> bearings(n);
+    std::vector<double> distances(n);
+    calculate_bearing_batch(from.span(n), to.span(n), bearings.data());
+    haversine_distance_batch(from.span(n), to.span(n), distances.data());
+    for (std::size_t i = 0; i < n; ++i) {
+        const std::vector<double> a{from.lat[i], from.lon[i]};
+        const std::vector<double> b{to.lat[i], to.lon[i]};
+        const double bearing = calculate_bearing(a, b);
+        const double distance = haversine_distance(a, b);
+        // Between coincident points the bearing is rounding noise, which depends on whether
+        // the compiler fused the scalar arithmetic.
+        const bool coincident = a == b;
+        check(coincident || angle_difference(bearings[i], bearing) <= BEARING_TOLERANCE_DEG, "bearing", n, i,
+              bearings[i], bearing);
+        check(std::fabs(distances[i] - distance) <= DISTANCE_TOLERANCE_KM, "distance", n, i, distances[i], distance);
+    }
+}
+
+void check_translate(const Points& coords, std::size_t n, double bearing, double distance) {
+    std::vector<double> lat(n);
+    std::vector<double> lon(n);
+    translate_coordinates_batch(coords.span(n), bearing, distance, {lat.data(), lon.data(), n});
+
+    // `out` may alias the input.
+    std::vector<double> in_place_lat(coords.lat.begin(), coords.lat.begin() + n);
+    std::vector<double> in_place_lon(coords.lon.begin(), coords.lon.begin() + n);
+    translate_coordinates_batch({in_place_lat.data(), in_place_lon.data(), n}, bearing, distance,
+                                {in_place_lat.data(), in_place_lon.data(), n});
+
+    for (std::size_t i = 0; i < n; ++i) {
+        const std::vector<double> expected = translate_coordinates({coords.lat[i], coords.lon[i]}, bearing, distance);
+        check(std::fabs(lat[i] - expected[0]) <= COORDINATE_TOLERANCE_DEG, "translate lat", n, i, lat[i], expected[0]);
+        // Longitude is compared as arc along the parallel; near a pole a tiny position
+        // difference is a large longitude difference.
+        const double lon_arc = angle_difference(lon[i], expected[1]) * std::cos(expected[0] * M_PI / 180);
+        const bool pole_cap = 90 - std::fabs(coords.lat[i]) < POLE_CAP_DEG;
+        check(lon_arc <= (pole_cap ? POLE_LONGITUDE_TOLERANCE_DEG : COORDINATE_TOLERANCE_DEG), "translate lon", n, i,
+              lon[i], expected[1]);
+        check(in_place_lat[i] == lat[i] && in_place_lon[i] == lon[i], "translate in place", n, i, in_place_lat[i],
+              lat[i]);
+    }
+}
+
+} // namespace
+
+int main() {
+    std::printf("AVX2 kernels: %s\n", geodesy_simd_enabled() ? "on" : "off");
+
+    // Edge cases first, so every size below includes some of them.
+    Points from;
+    Points to;
+    // Across the antimeridian, both ways.
+    from.add(47.3977419, 179.9999);
+    to.add(47.3978, -179.9999);
+    from.add(-33.5, -179.95);
+    to.add(-33.4, 179.95);
+    // From, to and along the poles.
+    from.add(90, 0);
+    to.add(89.9, 45);
+    from.add(-89.99, 120);
+    to.add(-90, 0);
+    from.add(89.9999, -170);
+    to.add(89.9999, 10);
+    from.add(89.99999, 33);
+    to.add(89.999, 33);
+    from.add(-89.9995, -100);
+    to.add(-89.9995, 80);
+    // Coincident points, also at a pole.
+    from.add(47.3977419, 8.2455938);
+    to.add(47.3977419, 8.2455938);
+    from.add(-90, 0);
+    to.add(-90, 0);
+    // Equator and prime meridian.
+    from.add(0, 0);
+    to.add(0, 0.001);
+
+    std::mt19937_64 random(42);
+    std::uniform_real_distribution<double> latitude(-89.9, 89.9);
+    std::uniform_real_distribution<double> longitude(-180, 180);
+    std::uniform_real_distribution<double> offset(-0.05, 0.05);
+    while (from.lat.size() < 1027) {
+        // Nearby pairs, like ship and drone, with some far apart.
+        const double lat = latitude(random);
+        const double lon = longitude(random);
+        from.add(lat, lon);
+        if (from.lat.size() % 3 == 0) {
+            to.add(latitude(random), longitude(random));
+        } else {
+            to.add(std::max(-90.0, std::min(90.0, lat + offset(random))), lon + offset(random));
+        }
+    }
+
+    // 0, the tail alone, one and two vector blocks with every tail length, and a long run.
+    const std::size_t sizes[] = {0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 1027};
+    for (const std::size_t n : sizes) {
+        check_pairs(from, to, n);
+        check_translate(from, n, 37.5, 0.25);
+        // Over the poles and across the antimeridian.
+        check_translate(from, n, 0, 50);
+        check_translate(from, n, 180, 50);
+        check_translate(from, n, 90, 30);
+        check_translate(from, n, 271, 1500);
+    }
+
+    // Empty input must not touch the buffers.
+    double untouched = 1234;
+    calculate_bearing_batch({nullptr, nullptr, 0}, {nullptr, nullptr, 0}, &untouched);
+    haversine_distance_batch({nullptr, nullptr, 0}, {nullptr, nullptr, 0}, &untouched);
+    translate_coordinates_batch({nullptr, nullptr, 0}, 10, 1, {&untouched, &untouched, 0});
+    check(untouched == 1234, "empty batch", 0, 0, untouched, 1234);
+
+    if (failures) {
+        std::printf("%d failures\n", failures);
+        return 1;
+    }
+    std::printf("ok\n");
+    return 0;
+}
@@ -0,0 +1,133 @@
+// Checks the error bounds geodesy.h documents for each tier (GeodesyBounds) against the
+// Wgs84 tier, over random point pairs within each tier's max_range_m at |latitude| <= 80
+// degrees. The Wgs84 tier itself is checked against Vincenty's published example.
+#include "geodesy.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <type_traits>
+
+namespace {
+
+// Bearings are not compared below this distance, where a rounding error in the position
+// is a large angle.
+const double BEARING_MIN_DISTANCE_M = 10;
+// Below this the reference distance of a placed point is noise of the bound's size.
+const double DESTINATION_MIN_DISTANCE_M = 1;
+const double MAX_LATITUDE_DEG = 80;
+
+int failures = 0;
+
+void check(bool ok, const char* tier, const char* what, double lat, double lon, double bearing, double distance,
+           double error, double bound) {
+    if (!ok) {
+        ++failures;
+        if (failures <= 20) {
+            std::printf("FAIL %s %s from %.9f,%.9f bearing %.6f distance %.3f: error %.3g > bound %.3g\n", tier, what,
+                        lat, lon, bearing, distance, error, bound);
+        }
+    }
+}
+
+double angle_difference(double a, double b) {
+    const double d = std::fmod(std::fabs(a - b), 360.0);
+    return std::min(d, 360.0 - d);
+}
+
+// Worst error seen, as a fraction of the bound.
+struct Worst {
+    double distance = 0;
+    double bearing = 0;
+    double destination = 0;
+};
+
+template <GeodesyTier Tier, typename T>
+void check_tier(const char* name, int samples) {
+    using Reference = Geodesy<GeodesyTier::Wgs84, double>;
+    const GeodesyErrorBound bound = Geodesy<Tier, T>::error_bound;
+
+    std::mt19937_64 random(7);
+    std::uniform_real_distribution<double> latitude(-MAX_LATITUDE_DEG, MAX_LATITUDE_DEG);
+    std::uniform_real_distribution<double> longitude(-180, 180);
+    std::uniform_real_distribution<double> bearings(0, 360);
+    std::uniform_real_distribution<double> unit(0, 1);
+
+    Worst worst;
+    for (int i = 0; i < samples; ++i) {
+        const double lat = latitude(random);
+        const double lon = longitude(random);
+        const double bearing = bearings(random);
+        // Mostly spread over the area within range, some very short.
+        const double distance = i % 10 == 0 ? bound.max_range_m * 1e-3 * unit(random)
+                                            : bound.max_range_m * std::sqrt(unit(random));
+        const Reference reference(lat, lon);
+        double to_lat;
+        double to_lon;
+        reference.destination(bearing, distance, to_lat, to_lon);
+        if (std::fabs(to_lat) > MAX_LATITUDE_DEG) {
+            continue;
+        }
+
+        const Geodesy<Tier, T> geodesy(lat, lon);
+        const double allowed = bound.distance_error_m(distance);
+        const double error = std::fabs(geodesy.distance_m(to_lat, to_lon) - distance);
+        check(error <= allowed, name, "distance", lat, lon, bearing, distance, error, allowed);
+        worst.distance = std::max(worst.distance, error / allowed);
+
+        if (distance >= BEARING_MIN_DISTANCE_M) {
+            const double bearing_error = angle_difference(geodesy.bearing_deg(to_lat, to_lon), bearing);
+            check(bearing_error <= bound.bearing_deg, name, "bearing", lat, lon, bearing, distance, bearing_error,
+                  bound.bearing_deg);
+            worst.bearing = std::max(worst.bearing, bearing_error / bound.bearing_deg);
+        }
+
+        // The other direction, as MissionFrame uses it through from_enu(): where the tier
+        // puts the point. Float
+        // tiers round the bearing and distance through T, which the bounds do not cover.
+        if (!std::is_same<T, double>::value || distance < DESTINATION_MIN_DISTANCE_M) {
+            continue;
+        }
+        double placed_lat;
+        double placed_lon;
+        geodesy.destination(static_cast<T>(bearing), static_cast<T>(distance), placed_lat, placed_lon);
+        const double placed_error = std::fabs(reference.distance_m(placed_lat, placed_lon) - distance);
+        check(placed_error <= allowed, name, "destination", lat, lon, bearing, distance, placed_error, allowed);
+        worst.destination = std::max(worst.destination, placed_error / allowed);
+    }
+    std::printf("%-22s worst error / bound: distance %.2f bearing %.2f", name, worst.distance, worst.bearing);
+    if (std::is_same<T, double>::value) {
+        std::printf(" destination %.2f", worst.destination);
+    }
+    std::printf("\n");
+}
+
+} // namespace
+
+int main() {
+    // Vincenty (1975), Flinders Peak to Buninyong on the WGS84 ellipsoid.
+    const Geodesy<GeodesyTier::Wgs84, double> flinders_peak(-37.951033416, 144.424867889);
+    const double vincenty_m = 54972.271;
+    const double vincenty_deg = 306.868159;
+    const double distance = flinders_peak.distance_m(-37.652821139, 143.926495528);
+    const double bearing = flinders_peak.bearing_deg(-37.652821139, 143.926495528);
+    const GeodesyErrorBound wgs84 = Geodesy<GeodesyTier::Wgs84, double>::error_bound;
+    check(std::fabs(distance - vincenty_m) <= wgs84.absolute_m, "wgs84<double>", "Vincenty distance", -37.951033416,
+          144.424867889, bearing, distance, std::fabs(distance - vincenty_m), wgs84.absolute_m);
+    // The published bearing is given to 0.01 arc seconds.
+    check(angle_difference(bearing, vincenty_deg) <= 3e-6, "wgs84<double>", "Vincenty bearing", -37.951033416,
+          144.424867889, bearing, distance, angle_difference(bearing, vincenty_deg), 3e-6);
+
+    check_tier<GeodesyTier::LocalTangentPlane, double>("local_tangent<double>", 200000);
+    check_tier<GeodesyTier::LocalTangentPlane, float>("local_tangent<float>", 200000);
+    check_tier<GeodesyTier::Spherical, double>("spherical<double>", 100000);
+    check_tier<GeodesyTier::Spherical, float>("spherical<float>", 100000);
+    check_tier<GeodesyTier::Wgs84, float>("wgs84<float>", 50000);
+
+    if (failures) {
+        std::printf("%d failures\n", failures);
+        return 1;
+    }
+    std::printf("ok\n");
+    return 0;
+}
@@ -0,0 +1,154 @@
+// Checks MissionSync::push against mock vehicles: one that never answers partial writes
+// (as PX4, which ignores MISSION_WRITE_PARTIAL_LIST) and one that accepts them.
+#include "mission_sync.h"
+#include <algorithm>
+#include <cstdio>
+#include <vector>
+
+namespace {
+
+int failures = 0;
+
+void check(bool ok, const char* what) {
+    if (!ok) {
+        ++failures;
+        std::printf("FAIL %s\n", what);
+    }
+}
+
+class MockLink : public MissionLink {
+public:
+    explicit MockLink(bool partial_supported) :
+        _partial_supported(partial_supported)
+    {}
+
+    bool download(MissionItems& items) override {
+        items = vehicle;
+        return true;
+    }
+    bool upload(const MissionItems& items) override {
+        ++uploads;
+        vehicle = items;
+        return true;
+    }
+    bool write_partial(const MissionItems& items, uint16_t start, uint16_t end) override {
+        ++partial_attempts;
+        if (cancel_during_partial) {
+            cancel_during_partial = false;
+            cancel();
+            return false;
+        }
+        if (!_partial_supported) {
+            return false;
+        }
+        std::copy(items.begin() + start, items.begin() + end + 1, vehicle.begin() + start);
+        return true;
+    }
+
+    MissionItems vehicle;
+    int uploads = 0;
+    int partial_attempts = 0;
+    // The next partial write is cancelled while it runs.
+    bool cancel_during_partial = false;
+
+private:
+    bool _partial_supported;
+};
+
+MissionItems make_mission(std::size_t n) {
+    MissionItems items(n);
+    for (std::size_t i = 0; i < n; ++i) {
+        items[i].seq = static_cast<uint32_t>(i);
+        items[i].frame = 6; // MAV_FRAME_GLOBAL_RELATIVE_ALT_INT
+        items[i].command = 16; // MAV_CMD_NAV_WAYPOINT
+        items[i].x = 473977419 + static_cast<int32_t>(i) * 1000;
+        items[i].y = 85455938;
+        items[i].z = 20;
+    }
+    return items;
+}
+
+bool same_mission(const MissionItems& a, const MissionItems& b) {
+    if (a.size() != b.size()) {
+        return false;
+    }
+    for (std::size_t i = 0; i < a.size(); ++i) {
+        if (a[i].seq != b[i].seq || a[i].x != b[i].x || a[i].y != b[i].y || a[i].z != b[i].z) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// The mission with item `index` moved north by `step` (degrees * 1e7).
+MissionItems moved(MissionItems items, std::size_t index, int32_t step) {
+    items[index].x += step;
+    return items;
+}
+
+void partial_writes_unanswered() {
+    MockLink link(false);
+    link.vehicle = make_mission(10);
+    MissionSync sync(link);
+    check(sync.load(), "unanswered: load");
+
+    MissionItems target = moved(sync.base(), 3, 10);
+    check(sync.push(target), "unanswered: first push falls back to a full upload");
+    check(link.partial_attempts == 1, "unanswered: first push tries one partial write");
+    check(link.uploads == 1, "unanswered: first push uploads once");
+    check(!sync.partial_writes_supported(), "unanswered: partial writes turned off");
+    check(same_mission(link.vehicle, target), "unanswered: vehicle has the first target");
+
+    for (int32_t step = 20; step <= 50; step += 10) {
+        target = moved(sync.base(), 3, step);
+        check(sync.push(target), "unanswered: later push");
+    }
+    check(link.partial_attempts == 1, "unanswered: later pushes skip partial writes");
+    check(link.uploads == 5, "unanswered: later pushes upload at once");
+    check(sync.stats().partial_writes == 0, "unanswered: no partial writes counted");
+    check(sync.stats().full_uploads == 5, "unanswered: full uploads counted");
+    check(same_mission(link.vehicle, target), "unanswered: vehicle has the last target");
+}
+
+void partial_writes_answered() {
+    MockLink link(true);
+    link.vehicle = make_mission(10);
+    MissionSync sync(link);
+    check(sync.load(), "answered: load");
+
+    MissionItems target = moved(sync.base(), 3, 10);
+    check(sync.push(target), "answered: push");
+    check(link.partial_attempts == 1 && link.uploads == 0, "answered: one partial write, no upload");
+
+    // A cancelled partial write says nothing about the vehicle.
+    link.cancel_during_partial = true;
+    check(!sync.push(moved(sync.base(), 3, 20)), "answered: cancelled push fails");
+    link.clear_cancel();
+    check(sync.partial_writes_supported(), "answered: cancel keeps partial writes on");
+
+    target = moved(sync.base(), 5, 30);
+    check(sync.push(target), "answered: push after cancel");
+    check(same_mission(link.vehicle, target), "answered: vehicle has the last target");
+    check(sync.stats().full_uploads == 1, "answered: resync after the cancel is one full upload");
+
+    target = moved(sync.base(), 7, 40);
+    const int attempts = link.partial_attempts;
+    check(sync.push(target), "answered: push after resync");
+    check(link.partial_attempts > attempts && sync.stats().full_uploads == 1,
+          "answered: back to partial writes after resync");
+    check(same_mission(link.vehicle, target), "answered: vehicle has the resync'd target");
+}
+
+} // namespace
+
+int main() {
+    partial_writes_unanswered();
+    partial_writes_answered();
+
+    if (failures) {
+        std::printf("%d failures\n", failures);
+        return 1;
+    }
+    std::printf("ok\n");
+    return 0;
+}
@@ -0,0 +1,613 @@
+// Stand-in MAVLink vehicles for running takeoff_and_land without PX4 SITL, and for load
+// and latency tests with many vehicles at high telemetry rates:
+//
+//   vehicle_simulator [config]
+//
+// Without a config it replaces the two SITL instances the single-pair mode expects: a
+// drone (sysid 1) sending to udp 127.0.0.1:14540 and a ship (sysid 2) behind a TCP
+// server on port 5772. Config lines ('#' starts a comment):
+//
+//   position_rate_hz <hz>            default telemetry rates for the vehicles below
+//   attitude_rate_hz <hz>
+//   seed <n>                         random seed for loss and jitter
+//   link <name> udp <host>:<port> [loss <p>] [delay_ms <ms>] [jitter_ms <ms>]
+//   link <name> tcp_server <port> [loss <p>] [delay_ms <ms>] [jitter_ms <ms>]
+//   vehicle <sysid> drone|ship <link> stationary <lat> <lon> [alt_m]
+//   vehicle <sysid> drone|ship <link> line <lat> <lon> <speed_m_s> <heading_deg>
+//   vehicle <sysid> drone|ship <link> circle <lat> <lon> <speed_m_s> <radius_m>
+//   pairs <count> <link> <first_sysid> <lat> <lon> <speed_m_s>
+//
+// `pairs` adds drone/ship pairs (drone = first_sysid + 2i, ship = the next sysid) with
+// the ships circling near their drones, and prints the matching fleet config lines.
+// Loss and delay apply to each MAVLink packet in both directions.
+
+#include "sim_vehicle.h"
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <csignal>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <memory>
+#include <queue>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+std::atomic<bool> stop_requested{false};
+
+struct LinkFaults {
+    double loss = 0;
+    double delay_ms = 0;
+    double jitter_ms = 0;
+};
+
+struct LinkStats {
+    uint64_t packets_sent = 0;
+    uint64_t packets_received = 0;
+    uint64_t packets_dropped = 0;
+};
+
+// One transport shared by any number of simulated vehicles.
+class Link {
+public:
+    Link(std::string name, LinkFaults link_faults) : faults(link_faults), _name(std::move(name)) {}
+    virtual ~Link() = default;
+
+    virtual bool open() = 0;
+    virtual void send(const uint8_t* data, std::size_t size) = 0;
+    // Adds the descriptors to wait on.
+    virtual void poll_fds(std::vector<pollfd>& fds) const = 0;
+    // Reads whatever is pending and hands complete messages to `deliver`.
+    virtual void receive(const std::function<void(const mavlink_message_t&)>& deliver) = 0;
+
+    const std::string& name() const { return _name; }
+
+    LinkFaults faults;
+    LinkStats stats;
+
+protected:
+    // Frames a byte stream with a parser state of our own, so the number of links is not
+    // limited by the MAVLink channel count.
+    void parse(const uint8_t* data, std::size_t size, mavlink_message_t& buffer, mavlink_status_t& status,
+               const std::function<void(const mavlink_message_t&)>& deliver) {
+        for (std::size_t i = 0; i < size; ++i) {
+            mavlink_message_t message;
+            mavlink_status_t message_status;
+            if (mavlink_frame_char_buffer(&buffer, &status, data[i], &message, &message_status) ==
+                MAVLINK_FRAMING_OK) {
+                deliver(message);
+            }
+        }
+    }
+
+private:
+    std::string _name;
+};
+
+// Sends to a fixed address like PX4 SITL does; the ground station answers to our source port.
+class UdpLink : public Link {
+public:
+    UdpLink(std::string name, LinkFaults faults, std::string host, uint16_t port) :
+        Link(std::move(name), faults), _host(std::move(host)), _port(port)
+    {}
+
+    ~UdpLink() override {
+        if (_fd >= 0) {
+            ::close(_fd);
+        }
+    }
+
+    bool open() override {
+        _fd = ::socket(AF_INET, SOCK_DGRAM, 0);
+        if (_fd < 0) {
+            return false;
+        }
+        ::fcntl(_fd, F_SETFL, O_NONBLOCK);
+        std::memset(&_remote, 0, sizeof(_remote));
+        _remote.sin_family = AF_INET;
+        _remote.sin_port = htons(_port);
+        if (::inet_pton(AF_INET, _host.c_str(), &_remote.sin_addr) != 1) {
+            addrinfo hints{};
+            hints.ai_family = AF_INET;
+            addrinfo* result = nullptr;
+            if (::getaddrinfo(_host.c_str(), nullptr, &hints, &result) != 0 || !result) {
+                return false;
+            }
+            _remote.sin_addr = reinterpret_cast<sockaddr_in*>(result->ai_addr)->sin_addr;
+            ::freeaddrinfo(result);
+        }
+        return true;
+    }
+
+    void send(const uint8_t* data, std::size_t size) override {
+        ::sendto(_fd, data, size, 0, reinterpret_cast<const sockaddr*>(&_remote), sizeof(_remote));
+    }
+
+    void poll_fds(std::vector<pollfd>& fds) const override { fds.push_back({_fd, POLLIN, 0}); }
+
+    void receive(const std::function<void(const mavlink_message_t&)>& deliver) override {
+        uint8_t buffer[2048];
+        ssize_t size;
+        while ((size = ::recv(_fd, buffer, sizeof(buffer), 0)) > 0) {
+            parse(buffer, static_cast<std::size_t>(size), _rx_message, _rx_status, deliver);
+        }
+    }
+
+private:
+    std::string _host;
+    uint16_t _port;
+    int _fd = -1;
+    sockaddr_in _remote{};
+    mavlink_message_t _rx_message{};
+    mavlink_status_t _rx_status{};
+};
+
+// Listens like the second SITL on tcp://:5772; every connected client gets every message.
+class TcpServerLink : public Link {
+public:
+    TcpServerLink(std::string name, LinkFaults faults, uint16_t port) :
+        Link(std::move(name), faults), _port(port)
+    {}
+
+    ~TcpServerLink() override {
+        for (auto& client : _clients) {
+            ::close(client->fd);
+        }
+        if (_listen_fd >= 0) {
+            ::close(_listen_fd);
+        }
+    }
+
+    bool open() override {
+        _listen_fd = ::socket(AF_INET, SOCK_STREAM, 0);
+        if (_listen_fd < 0) {
+            return false;
+        }
+        const int yes = 1;
+        ::setsockopt(_listen_fd, SOL_SOCKET, SO_REUSEADDR, &yes, sizeof(yes));
+        sockaddr_in address{};
+        address.sin_family = AF_INET;
+        address.sin_addr.s_addr = htonl(INADDR_ANY);
+        address.sin_port = htons(_port);
+        if (::bind(_listen_fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0 ||
+            ::listen(_listen_fd, 4) != 0) {
+            return false;
+        }
+        ::fcntl(_listen_fd, F_SETFL, O_NONBLOCK);
+        return true;
+    }
+
+    void send(const uint8_t* data, std::size_t size) override {
+        for (auto& client : _clients) {
+            // A client that cannot keep up loses packets rather than stalling every vehicle.
+            ::send(client->fd, data, size, MSG_NOSIGNAL | MSG_DONTWAIT);
+        }
+    }
+
+    void poll_fds(std::vector<pollfd>& fds) const override {
+        fds.push_back({_listen_fd, POLLIN, 0});
+        for (const auto& client : _clients) {
+            fds.push_back({client->fd, POLLIN, 0});
+        }
+    }
+
+    void receive(const std::function<void(const mavlink_message_t&)>& deliver) override {
+        int fd;
+        while ((fd = ::accept(_listen_fd, nullptr, nullptr)) >= 0) {
+            ::fcntl(fd, F_SETFL, O_NONBLOCK);
+            const int yes = 1;
+            ::setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &yes, sizeof(yes));
+            _clients.emplace_back(new Client{fd, {}, {}});
+            std::fprintf(stderr, "%s: client connected\n", name().c_str());
+        }
+
+        uint8_t buffer[4096];
+        for (auto it = _clients.begin(); it != _clients.end();) {
+            Client& client = **it;
+            ssize_t size;
+            while ((size = ::recv(client.fd, buffer, sizeof(buffer), 0)) > 0) {
+                parse(buffer, static_cast<std::size_t>(size), client.rx_message, client.rx_status, deliver);
+            }
+            if (size == 0 || (size < 0 && errno != EAGAIN && errno != EWOULDBLOCK)) {
+                std::fprintf(stderr, "%s: client disconnected\n", name().c_str());
+                ::close(client.fd);
+                it = _clients.erase(it);
+            } else {
+                ++it;
+            }
+        }
+    }
+
+private:
+    struct Client {
+        int fd;
+        mavlink_message_t rx_message;
+        mavlink_status_t rx_status;
+    };
+
+    uint16_t _port;
+    int _listen_fd = -1;
+    std::vector<std::unique_ptr<Client>> _clients;
+};
+
+struct SimConfig {
+    std::vector<std::unique_ptr<Link>> links;
+    std::vector<std::pair<std::string, SimVehicleConfig>> vehicles;
+    unsigned seed = 1;
+};
+
+Link* find_link(SimConfig& config, const std::string& name) {
+    for (auto& link : config.links) {
+        if (link->name() == name) {
+            return link.get();
+        }
+    }
+    return nullptr;
+}
+
+bool parse_track(std::istringstream& in, SimTrack& track) {
+    std::string kind;
+    if (!(in >> kind >> track.latitude_deg >> track.longitude_deg)) {
+        return false;
+    }
+    if (kind == "stationary") {
+        track.kind = SimTrack::Kind::Stationary;
+        in >> track.altitude_m;
+        return true;
+    }
+    if (kind == "line") {
+        track.kind = SimTrack::Kind::Line;
+        return static_cast<bool>(in >> track.speed_m_s >> track.heading_deg);
+    }
+    if (kind == "circle") {
+        track.kind = SimTrack::Kind::Circle;
+        return static_cast<bool>(in >> track.speed_m_s >> track.radius_m) && track.radius_m > 0;
+    }
+    return false;
+}
+
+bool parse_faults(std::istringstream& in, LinkFaults& faults) {
+    std::string key;
+    while (in >> key) {
+        double value;
+        if (!(in >> value) || value < 0) {
+            return false;
+        }
+        if (key == "loss" && value <= 1) {
+            faults.loss = value;
+        } else if (key == "delay_ms") {
+            faults.delay_ms = value;
+        } else if (key == "jitter_ms") {
+            faults.jitter_ms = value;
+        } else {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool add_link(SimConfig& config, std::istringstream& in) {
+    std::string name;
+    std::string transport;
+    std::string address;
+    if (!(in >> name >> transport >> address) || find_link(config, name)) {
+        return false;
+    }
+    LinkFaults faults;
+    if (!parse_faults(in, faults)) {
+        return false;
+    }
+    if (transport == "udp") {
+        const auto colon = address.rfind(':');
+        if (colon == std::string::npos) {
+            return false;
+        }
+        config.links.emplace_back(new UdpLink(name, faults, address.substr(0, colon),
+                                              static_cast<uint16_t>(std::stoi(address.substr(colon + 1)))));
+        return true;
+    }
+    if (transport == "tcp_server") {
+        config.links.emplace_back(new TcpServerLink(name, faults, static_cast<uint16_t>(std::stoi(address))));
+        return true;
+    }
+    return false;
+}
+
+bool load_sim_config(const std::string& path, SimConfig& config, std::string& error) {
+    std::ifstream file(path);
+    if (!file) {
+        error = "cannot open " + path;
+        return false;
+    }
+
+    double position_rate_hz = 10;
+    double attitude_rate_hz = 10;
+    std::string line;
+    int line_number = 0;
+    while (std::getline(file, line)) {
+        ++line_number;
+        const auto comment = line.find('#');
+        if (comment != std::string::npos) {
+            line.erase(comment);
+        }
+        std::istringstream in(line);
+        std::string key;
+        if (!(in >> key)) {
+            continue;
+        }
+
+        bool ok = true;
+        try {
+            if (key == "position_rate_hz") {
+                ok = static_cast<bool>(in >> position_rate_hz);
+            } else if (key == "attitude_rate_hz") {
+                ok = static_cast<bool>(in >> attitude_rate_hz);
+            } else if (key == "seed") {
+                ok = static_cast<bool>(in >> config.seed);
+            } else if (key == "link") {
+                ok = add_link(config, in);
+            } else if (key == "vehicle") {
+                int sysid;
+                std::string type;
+                std::string link;
+                SimVehicleConfig vehicle;
+                ok = (in >> sysid >> type >> link) && sysid >= 1 && sysid <= 255 &&
+                     (type == "drone" || type == "ship") && find_link(config, link) && parse_track(in, vehicle.track);
+                vehicle.sysid = static_cast<uint8_t>(sysid);
+                vehicle.ship = type == "ship";
+                vehicle.position_rate_hz = position_rate_hz;
+                vehicle.attitude_rate_hz = attitude_rate_hz;
+                config.vehicles.emplace_back(link, vehicle);
+            } else if (key == "pairs") {
+                int count;
+                std::string link;
+                int first_sysid;
+                double latitude_deg;
+                double longitude_deg;
+                double speed_m_s;
+                ok = (in >> count >> link >> first_sysid >> latitude_deg >> longitude_deg >> speed_m_s) &&
+                     find_link(config, link) && first_sysid >= 1 && first_sysid + 2 * count - 1 <= 255;
+                for (int i = 0; ok && i < count; ++i) {
+                    // Pairs spaced ~100 m apart in latitude, each ship circling 50 m around its drone.
+                    SimVehicleConfig drone;
+                    drone.sysid = static_cast<uint8_t>(first_sysid + 2 * i);
+                    drone.track.latitude_deg = latitude_deg + i * 1e-3;
+                    drone.track.longitude_deg = longitude_deg;
+                    drone.position_rate_hz = position_rate_hz;
+                    drone.attitude_rate_hz = attitude_rate_hz;
+
+                    SimVehicleConfig ship = drone;
+                    ship.sysid = static_cast<uint8_t>(drone.sysid + 1);
+                    ship.ship = true;
+                    ship.track.kind = SimTrack::Kind::Circle;
+                    ship.track.speed_m_s = speed_m_s;
+                    ship.track.radius_m = 50;
+
+                    config.vehicles.emplace_back(link, drone);
+                    config.vehicles.emplace_back(link, ship);
+                    std::printf("pair sim%d %d %d\n", i, drone.sysid, ship.sysid);
+                }
+            } else {
+                ok = false;
+            }
+        } catch (const std::exception&) {
+            ok = false;
+        }
+
+        if (!ok) {
+            error = path + ":" + std::to_string(line_number) + ": invalid line '" + line + "'";
+            return false;
+        }
+    }
+
+    if (config.vehicles.empty()) {
+        error = path + ": needs at least one vehicle";
+        return false;
+    }
+    return true;
+}
+
+void default_config(SimConfig& config) {
+    config.links.emplace_back(new UdpLink("drone", {}, "127.0.0.1", 14540));
+    config.links.emplace_back(new TcpServerLink("ship", {}, 5772));
+
+    SimVehicleConfig drone;
+    drone.sysid = 1;
+    drone.track.latitude_deg = 47.3977419;
+    drone.track.longitude_deg = 8.5455938;
+    config.vehicles.emplace_back("drone", drone);
+
+    SimVehicleConfig ship = drone;
+    ship.sysid = 2;
+    ship.ship = true;
+    ship.track.kind = SimTrack::Kind::Line;
+    ship.track.speed_m_s = 5;
+    ship.track.heading_deg = 90;
+    config.vehicles.emplace_back("ship", ship);
+}
+
+// A packet held back by the delay injection.
+struct Delayed {
+    int64_t due_ns;
+    uint64_t order;
+    Link* link;
+    bool outgoing;
+    std::vector<uint8_t> bytes;
+    mavlink_message_t message;
+};
+
+struct LaterDelayed {
+    bool operator()(const Delayed& a, const Delayed& b) const {
+        return a.due_ns != b.due_ns ? a.due_ns > b.due_ns : a.order > b.order;
+    }
+};
+
+} // namespace
+
+int main(int argc, char** argv) {
+    SimConfig config;
+    if (argc > 1) {
+        std::string error;
+        if (!load_sim_config(argv[1], config, error)) {
+            std::fprintf(stderr, "%s\n", error.c_str());
+            return 1;
+        }
+    } else {
+        default_config(config);
+    }
+    std::fflush(stdout);
+
+    for (auto& link : config.links) {
+        if (!link->open()) {
+            std::fprintf(stderr, "%s: cannot open link: %s\n", link->name().c_str(), std::strerror(errno));
+            return 1;
+        }
+    }
+
+    std::signal(SIGINT, [](int) { stop_requested = true; });
+    std::signal(SIGTERM, [](int) { stop_requested = true; });
+
+    const auto start = Clock::now();
+    auto now_ns = [start]() {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start).count();
+    };
+
+    std::mt19937_64 rng(config.seed);
+    std::uniform_real_distribution<double> uniform(0.0, 1.0);
+    std::priority_queue<Delayed, std::vector<Delayed>, LaterDelayed> delayed;
+    uint64_t delayed_order = 0;
+
+    // Returns the delay to apply, or -1 when the packet is lost.
+    auto fault = [&](Link& link) -> int64_t {
+        if (link.faults.loss > 0 && uniform(rng) < link.faults.loss) {
+            ++link.stats.packets_dropped;
+            return -1;
+        }
+        const double delay_ms = link.faults.delay_ms + link.faults.jitter_ms * uniform(rng);
+        return static_cast<int64_t>(delay_ms * 1e6);
+    };
+
+    std::map<Link*, std::vector<std::unique_ptr<SimVehicle>>> vehicles_by_link;
+    std::vector<SimVehicle*> vehicles;
+    for (auto& entry : config.vehicles) {
+        Link* link = find_link(config, entry.first);
+        auto vehicle = std::make_unique<SimVehicle>(entry.second, [&, link](const mavlink_message_t& message) {
+            const int64_t delay_ns = fault(*link);
+            if (delay_ns < 0) {
+                return;
+            }
+            uint8_t buffer[MAVLINK_MAX_PACKET_LEN];
+            const uint16_t size = mavlink_msg_to_send_buffer(buffer, &message);
+            if (delay_ns == 0) {
+                link->send(buffer, size);
+                ++link->stats.packets_sent;
+                return;
+            }
+            delayed.push({now_ns() + delay_ns, delayed_order++, link, true, std::vector<uint8_t>(buffer, buffer + size),
+                          mavlink_message_t{}});
+        });
+        vehicles.push_back(vehicle.get());
+        vehicles_by_link[link].push_back(std::move(vehicle));
+    }
+
+    auto deliver = [&](Link* link, const mavlink_message_t& message) {
+        for (auto& vehicle : vehicles_by_link[link]) {
+            vehicle->handle(message, now_ns());
+        }
+    };
+
+    std::fprintf(stderr, "%zu vehicles on %zu links\n", vehicles.size(), config.links.size());
+
+    int64_t next_report_ns = 5000000000;
+    std::vector<pollfd> fds;
+    while (!stop_requested) {
+        int64_t now = now_ns();
+        for (SimVehicle* vehicle : vehicles) {
+            if (vehicle->next_due_ns() <= now) {
+                vehicle->tick(now);
+            }
+        }
+
+        while (!delayed.empty() && delayed.top().due_ns <= now) {
+            const Delayed& packet = delayed.top();
+            if (packet.outgoing) {
+                packet.link->send(packet.bytes.data(), packet.bytes.size());
+                ++packet.link->stats.packets_sent;
+            } else {
+                deliver(packet.link, packet.message);
+            }
+            delayed.pop();
+        }
+
+        // Sleep until the next telemetry or delayed packet is due, or a packet arrives.
+        int64_t wake_ns = now + 100000000;
+        for (SimVehicle* vehicle : vehicles) {
+            wake_ns = std::min(wake_ns, vehicle->next_due_ns());
+        }
+        if (!delayed.empty()) {
+            wake_ns = std::min(wake_ns, delayed.top().due_ns);
+        }
+        fds.clear();
+        for (auto& link : config.links) {
+            link->poll_fds(fds);
+        }
+        const int timeout_ms = static_cast<int>(std::max<int64_t>(0, (wake_ns - now + 999999) / 1000000));
+        if (::poll(fds.data(), fds.size(), timeout_ms) > 0) {
+            for (auto& link : config.links) {
+                Link* link_ptr = link.get();
+                link->receive([&, link_ptr](const mavlink_message_t& message) {
+                    ++link_ptr->stats.packets_received;
+                    const int64_t delay_ns = fault(*link_ptr);
+                    if (delay_ns < 0) {
+                        return;
+                    }
+                    if (delay_ns == 0) {
+                        deliver(link_ptr, message);
+                        return;
+                    }
+                    delayed.push({now_ns() + delay_ns, delayed_order++, link_ptr, false, {}, message});
+                });
+            }
+        }
+
+        now = now_ns();
+        if (now >= next_report_ns) {
+            next_report_ns += 5000000000;
+            uint64_t set_home = 0;
+            uint64_t uploads = 0;
+            uint64_t partial_writes = 0;
+            for (SimVehicle* vehicle : vehicles) {
+                set_home += vehicle->stats().set_home_commands;
+                uploads += vehicle->stats().mission_uploads;
+                partial_writes += vehicle->stats().partial_writes;
+            }
+            for (auto& link : config.links) {
+                std::fprintf(stderr, "%s: sent %llu, received %llu, dropped %llu\n", link->name().c_str(),
+                             static_cast<unsigned long long>(link->stats.packets_sent),
+                             static_cast<unsigned long long>(link->stats.packets_received),
+                             static_cast<unsigned long long>(link->stats.packets_dropped));
+            }
+            std::fprintf(stderr, "DO_SET_HOME: %llu, mission uploads: %llu, partial writes: %llu\n",
+                         static_cast<unsigned long long>(set_home), static_cast<unsigned long long>(uploads),
+                         static_cast<unsigned long long>(partial_writes));
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,66 @@
+#include "worker_pool.h"
+#include <algorithm>
+
+WorkerPool::WorkerPool(std::size_t threads) {
+    if (threads == 0) {
+        threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+    _threads.reserve(threads);
+    for (std::size_t i = 0; i < threads; ++i) {
+        _threads.emplace_back([this]() { run(); });
+    }
+}
+
+WorkerPool::~WorkerPool() {
+    stop();
+}
+
+void WorkerPool::stop() {
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _stopping = true;
+    }
+    _cv.notify_all();
+    for (auto& thread : _threads) {
+        if (thread.joinable()) {
+            thread.join();
+        }
+    }
+}
+
+void WorkerPool::post(Task task) {
+    post_at(Clock::now(), std::move(task));
+}
+
+void WorkerPool::post_at(Clock::time_point when, Task task) {
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _queue.push({when, _next_order++, std::move(task)});
+    }
+    _cv.notify_one();
+}
+
+void WorkerPool::run() {
+    std::unique_lock<std::mutex> lock(_mutex);
+    while (true) {
+        if (_stopping) {
+            return;
+        }
+        if (_queue.empty()) {
+            _cv.wait(lock);
+            continue;
+        }
+        const auto when = _queue.top().when;
+        if (Clock::now() < when) {
+            _cv.wait_until(lock, when);
+            continue;
+        }
+
+        // priority_queue::top() is const; the entry is popped right after, so moving is safe.
+        Task task = std::move(const_cast<Entry&>(_queue.top()).task);
+        _queue.pop();
+        lock.unlock();
+        task();
+        lock.lock();
+    }
+}
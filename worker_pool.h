@@ -0,0 +1,59 @@
+#ifndef WORKER_POOL_H
+#define WORKER_POOL_H
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
+
+// Fixed set of worker threads sharing one deadline-ordered task queue. Used as the
+// reactor for per-vehicle work so the thread count does not grow with the fleet.
+class WorkerPool {
+public:
+    using Clock = std::chrono::steady_clock;
+    using Task = std::function<void()>;
+
+    // 0 threads means one per hardware thread.
+    explicit WorkerPool(std::size_t threads = 0);
+    ~WorkerPool();
+
+    WorkerPool(const WorkerPool&) = delete;
+    WorkerPool& operator=(const WorkerPool&) = delete;
+
+    void post(Task task);
+    // Runs `task` no earlier than `when`.
+    void post_at(Clock::time_point when, Task task);
+
+    // Joins the workers; tasks still queued are dropped. Call before destroying anything
+    // the queued tasks refer to. Also done by the destructor.
+    void stop();
+
+    std::size_t size() const { return _threads.size(); }
+
+private:
+    struct Entry {
+        Clock::time_point when;
+        uint64_t order;
+        Task task;
+    };
+    struct Later {
+        bool operator()(const Entry& a, const Entry& b) const {
+            return a.when != b.when ? a.when > b.when : a.order > b.order;
+        }
+    };
+
+    void run();
+
+    std::mutex _mutex;
+    std::condition_variable _cv;
+    std::priority_queue<Entry, std::vector<Entry>, Later> _queue;
+    uint64_t _next_order = 0;
+    bool _stopping = false;
+    std::vector<std::thread> _threads;
+};
+
+#endif // WORKER_POOL_H